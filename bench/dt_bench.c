@@ -0,0 +1,415 @@
+/*********************************************************
+* FILE NAME		:	dt_bench.c
+* VERSION		:	1.0
+* DESCRIPTION	:	Trace replayer and benchmarks of the host
+*					table code, built in userspace against
+*					kernel_shim.h.
+*
+*					The trace is read from a file or generated
+*					with a skewed host mix, see dt_harness.h.
+*					Each benchmark runs in its own process on a
+*					freshly initialised table, costs are in cycles
+*					of get_cycles() per operation.
+*
+* CREATE DATE	:	17/10/2026
+*********************************************************/
+#include <unistd.h>
+#include <getopt.h>
+#include <sys/wait.h>
+#include <time.h>
+#include "dt_harness.h"
+#include "data_traffic_flow.h"
+#include "data_traffic_class.h"
+
+/* rules of the replay, the ones of a home router */
+#define BENCH_CLASS_RULES \
+	"web tcp 80,443,8080\n" \
+	"dns any 53\n" \
+	"video tcp 1935\n" \
+	"video udp 3478-3497\n" \
+	"game udp 27000-27100\n"
+
+/* timed loops of the per packet benchmarks, the best run is kept */
+#define BENCH_RUNS 5
+
+static unsigned int g_hosts = 1024;
+static unsigned int g_packets = 1000000;
+
+static double bench_seconds(const struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/* the accounting of a whole trace, timer included */
+static void bench_replay(const struct trace_pkt *pkts, unsigned int num)
+{
+	struct timespec start;
+	cycles_t cycles = 0;
+	unsigned int seconds;
+
+	harness_init(g_hosts, DEFAULT_FLOW_CAPACITY, BENCH_CLASS_RULES);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	seconds = trace_replay(pkts, num, &cycles);
+
+	printf("replay:  %u packets, %u s of trace in %.2f s wall, %.0f cycles/packet\n",
+		num, seconds, bench_seconds(&start), (double)cycles / num);
+	printf("         %u hosts recorded, %lu evicted (%lu active)\n",
+		g_host_count, g_evict_count, g_evict_active_count);
+}
+
+/* hosts looked up in random order, all hits */
+static void bench_lookup(void)
+{
+	unsigned char (*macs)[ETH_ALEN] = malloc(65536 * ETH_ALEN);
+	unsigned int i, hits = 0, rounds = max(g_packets, g_hosts);
+	struct timespec start;
+	cycles_t t;
+	double secs;
+
+	harness_init(g_hosts, 0, NULL);
+	harness_fill(g_hosts);
+	for (i = 0; i < 65536; i++)
+		harness_mac(rand() % g_hosts, macs[i]);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	t = get_cycles();
+	for (i = 0; i < rounds; i++)
+		hits += hlist_find_host_by_mac(macs[i & 0xffff]) != NULL;
+	t = get_cycles() - t;
+	secs = bench_seconds(&start);
+
+	printf("lookup:  %u hosts, %.1f M lookups/s, %.0f cycles/lookup, %u/%u hits\n",
+		g_hosts, rounds / secs / 1e6, (double)t / rounds, hits, rounds);
+	free(macs);
+}
+
+/* a new host per call, the table never full */
+static void bench_insert(void)
+{
+	unsigned char mac_addr[ETH_ALEN];
+	cycles_t t, cycles = 0;
+	unsigned int i;
+
+	harness_init(g_hosts, 0, NULL);
+
+	for (i = 0; i < g_hosts; i++) {
+		harness_mac(i, mac_addr);
+		t = get_cycles();
+		harness_lookup_or_add(mac_addr, i);
+		cycles += get_cycles() - t;
+		/* the grace periods and works are not timed */
+		shim_run_pending();
+	}
+
+	printf("insert:  %u hosts, %.0f cycles/insert, %u recorded\n",
+		g_hosts, (double)cycles / g_hosts, g_host_count);
+}
+
+/*************************************************************
+  Function:     bench_evict
+  Description:  a new host per packet into a full table. The
+                first packet evicts a host, its entry is free
+                after a grace period and the next packet of the
+                new host records it. Both packets are timed.
+*************************************************************/
+static void bench_evict(void)
+{
+	unsigned char mac_addr[ETH_ALEN];
+	unsigned long evicted = 0;
+	cycles_t t, cycles = 0;
+	unsigned int i, recorded = 0;
+	struct host_entry *host = NULL;
+
+	harness_init(g_hosts, 0, NULL);
+	harness_fill(g_hosts);
+	evicted = g_evict_count;
+
+	for (i = g_hosts; i < 2 * g_hosts; i++) {
+		harness_mac(i, mac_addr);
+		t = get_cycles();
+		host = harness_lookup_or_add(mac_addr, i);
+		cycles += get_cycles() - t;
+		shim_run_pending();
+		if (host != NULL) {
+			recorded++;
+			continue;
+		}
+
+		t = get_cycles();
+		recorded += harness_lookup_or_add(mac_addr, i) != NULL;
+		cycles += get_cycles() - t;
+		shim_run_pending();
+	}
+	evicted = g_evict_count - evicted;
+
+	printf("evict:   %u hosts, %.0f cycles/insert with eviction, %lu evicted, %u recorded\n",
+		g_hosts, (double)cycles / g_hosts, evicted, recorded);
+}
+
+/**************************************************************
+  Function:     bench_sweep
+  Description:  cost of the timer sweep. The hosts are recorded
+                over HOST_EXPIRE_TIME seconds, so the wheel is
+                evenly loaded. Then all of them send a packet
+                every second, each sweep only queues its slot
+                again, then the traffic stops and the hosts expire.
+**************************************************************/
+static void bench_sweep(void)
+{
+	unsigned char mac_addr[ETH_ALEN];
+	unsigned int per_second = DIV_ROUND_UP(g_hosts, HOST_EXPIRE_TIME);
+	unsigned int i, s, n = 0, sweeps;
+	cycles_t t, busy = 0, busy_max = 0, idle = 0, idle_max = 0;
+	struct harness_pkt pkt;
+	struct sk_buff skb;
+
+	harness_init(g_hosts, 0, NULL);
+
+	for (s = 0; s < HOST_EXPIRE_TIME; s++) {
+		for (i = 0; i < per_second && n < g_hosts; i++, n++) {
+			harness_mac(n, mac_addr);
+			harness_lookup_or_add(mac_addr, n);
+			shim_run_pending();
+		}
+		harness_tick();
+	}
+
+	/* every host active each second */
+	for (s = 0; s < HOST_EXPIRE_TIME; s++) {
+		for (i = 0; i < g_hosts; i++) {
+			harness_mac(i, mac_addr);
+			harness_skb(&skb, &pkt, i, OUTBOUND, IPPROTO_TCP, 443, 100);
+			harness_account(&skb, &pkt, mac_addr, OUTBOUND);
+		}
+		jiffies += HZ;
+		t = get_cycles();
+		data_traffic_timer.function(data_traffic_timer.data);
+		t = get_cycles() - t;
+		shim_run_pending();
+		busy += t;
+		busy_max = max(busy_max, t);
+	}
+
+	/* no more traffic, every host expires once */
+	for (sweeps = 0; g_host_count != 0 && sweeps < 3 * HOST_EXPIRE_TIME; sweeps++) {
+		jiffies += HZ;
+		t = get_cycles();
+		data_traffic_timer.function(data_traffic_timer.data);
+		t = get_cycles() - t;
+		shim_run_pending();
+		idle += t;
+		idle_max = max(idle_max, t);
+	}
+
+	printf("sweep:   %u hosts, active: %.0f cycles/sweep (max %llu), "
+		"expiring: %.0f cycles/sweep (max %llu) over %u sweeps\n",
+		g_hosts, (double)busy / HOST_EXPIRE_TIME, (unsigned long long)busy_max,
+		(double)idle / max(sweeps, 1U), (unsigned long long)idle_max, sweeps);
+}
+
+/**************************************************************
+  Function:     bench_packet_path
+  Description:  cycles per packet of the accounting with the
+                lookup done as before lookup_or_add_host_entry, a
+                walk to find the host then another one to record
+                or get it, against the single walk, with and
+                without the batch of back to back packets
+**************************************************************/
+static void bench_packet_path(void)
+{
+	static const char *const names[] = { "two walks:", "one walk:", "one walk + batch:" };
+	unsigned int *hosts = malloc(65536 * sizeof(*hosts));
+	unsigned int i, host, rounds = max(g_packets, g_hosts);
+	bool *batch = shim_param_batch_accounting;
+	unsigned char mac_addr[ETH_ALEN];
+	struct harness_pkt pkt;
+	struct sk_buff skb;
+	cycles_t t, best[ARRAY_SIZE(names)] = { ~(cycles_t)0, ~(cycles_t)0, ~(cycles_t)0 };
+	int pass, run;
+
+	harness_init(g_hosts, 0, NULL);
+	harness_fill(g_hosts);
+	/* bursts of 4 packets of a host, as TCP windows do */
+	for (i = 0; i < 65536; i++)
+		hosts[i] = (i & 3) != 0 ? hosts[i - 1] : harness_pick_host(g_hosts);
+
+	/* the passes are interleaved, a drift of the machine hits them all */
+	for (run = 0; run < BENCH_RUNS; run++) {
+		for (pass = 0; pass < ARRAY_SIZE(names); pass++) {
+			*batch = pass == 2;
+			t = get_cycles();
+			for (i = 0; i < rounds; i++) {
+				host = hosts[i & 0xffff];
+				harness_mac(host, mac_addr);
+				harness_skb(&skb, &pkt, host, INBOUND, IPPROTO_TCP, 443, 1500);
+				/* the walk of the former add_host_entry */
+				if (pass == 0 && hlist_find_host_by_mac(mac_addr) == NULL)
+					continue;
+				harness_account(&skb, &pkt, mac_addr, INBOUND);
+			}
+			best[pass] = min(best[pass], get_cycles() - t);
+		}
+	}
+
+	for (pass = 0; pass < ARRAY_SIZE(names); pass++)
+		printf("packet:  %u hosts, %-24s %.0f cycles/packet\n", g_hosts,
+			names[pass], (double)best[pass] / rounds);
+	free(hosts);
+}
+
+/**************************************************************
+  Function:     bench_class
+  Description:  cycles per packet of the accounting of the trace
+                mix without class rules, so without the L4 parse,
+                and with BENCH_CLASS_RULES. The share of packets
+                the rules classify is counted outside the timing.
+**************************************************************/
+static void bench_class(void)
+{
+	static const char *const names[] = { "no rules:", "class rules:" };
+	unsigned int num = 65536, i, classified = 0, rounds = max(g_packets, g_hosts);
+	struct trace_pkt *pkts = malloc(num * sizeof(*pkts));
+	const struct trace_pkt *p = NULL;
+	struct flow_tuple tuple;
+	struct harness_pkt pkt;
+	struct sk_buff skb;
+	cycles_t t, best[ARRAY_SIZE(names)] = { ~(cycles_t)0, ~(cycles_t)0 };
+	int pass, run;
+
+	harness_init(g_hosts, 0, NULL);
+	trace_generate(pkts, num, g_hosts);
+	harness_fill(g_hosts);
+
+	for (run = 0; run < BENCH_RUNS; run++) {
+		for (pass = 0; pass < ARRAY_SIZE(names); pass++) {
+			if (class_rules_load(pass == 0 ? "" : BENCH_CLASS_RULES) < 0) {
+				fprintf(stderr, "load class rules failed\n");
+				exit(2);
+			}
+			shim_run_pending();
+
+			t = get_cycles();
+			for (i = 0; i < rounds; i++) {
+				p = &pkts[i & (num - 1)];
+				harness_skb(&skb, &pkt, harness_mac_index(p->mac_addr), p->direction,
+						p->protocol, p->remote_port, p->len);
+				harness_account(&skb, &pkt, (unsigned char *)p->mac_addr, p->direction);
+			}
+			best[pass] = min(best[pass], get_cycles() - t);
+		}
+	}
+
+	memset(&tuple, 0, sizeof(tuple));
+	for (i = 0; i < num; i++) {
+		tuple.protocol = pkts[i].protocol;
+		tuple.remote_port = htons(pkts[i].remote_port);
+		tuple.local_port = htons(40000);
+		classified += class_lookup(&tuple) != CLASS_OTHER;
+	}
+
+	for (pass = 0; pass < ARRAY_SIZE(names); pass++)
+		printf("class:   %u hosts, %-24s %.0f cycles/packet\n", g_hosts,
+			names[pass], (double)best[pass] / rounds);
+	printf("         %.1f%% of the packets classified\n", 100.0 * classified / num);
+	free(pkts);
+}
+
+/* run a benchmark on a fresh table in its own process */
+static void bench_run(void (*fn)(void))
+{
+	pid_t pid;
+
+	fflush(stdout);
+	pid = fork();
+	if (pid < 0) {
+		perror("fork");
+		exit(2);
+	}
+	if (pid == 0) {
+		fn();
+		exit(0);
+	}
+	waitpid(pid, NULL, 0);
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "usage: %s [-n hosts] [-p packets] [-s seed] [-r trace] [-w trace] [-v]\n"
+		"  -n  hosts of the synthetic trace and host_capacity, default 1024\n"
+		"  -p  packets of the synthetic trace and timed rounds, default 1000000\n"
+		"  -r  replay a trace file instead of the synthetic one\n"
+		"  -w  write the synthetic trace to a file and exit\n"
+		"  -v  print the log of the module\n", name);
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	const char *read_path = NULL, *write_path = NULL;
+	struct trace_pkt *pkts = NULL;
+	unsigned int num;
+	pid_t pid;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:p:s:r:w:v")) != -1) {
+		switch (opt) {
+		case 'n':
+			g_hosts = strtoul(optarg, NULL, 0);
+			break;
+		case 'p':
+			g_packets = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			g_seed = strtoul(optarg, NULL, 0);
+			break;
+		case 'r':
+			read_path = optarg;
+			break;
+		case 'w':
+			write_path = optarg;
+			break;
+		case 'v':
+			shim_verbose = true;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (g_hosts == 0 || g_packets == 0)
+		usage(argv[0]);
+
+	if (read_path != NULL) {
+		num = trace_read(read_path, &pkts);
+	} else {
+		num = g_packets;
+		pkts = malloc(num * sizeof(*pkts));
+		trace_generate(pkts, num, g_hosts);
+	}
+	if (write_path != NULL) {
+		trace_write(write_path, pkts, num);
+		return 0;
+	}
+
+	fflush(stdout);
+	pid = fork();
+	if (pid == 0) {
+		bench_replay(pkts, num);
+		exit(0);
+	}
+	waitpid(pid, NULL, 0);
+
+	bench_run(bench_lookup);
+	bench_run(bench_insert);
+	bench_run(bench_evict);
+	bench_run(bench_sweep);
+	bench_run(bench_packet_path);
+	bench_run(bench_class);
+
+	free(pkts);
+
+	return 0;
+}
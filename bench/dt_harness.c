@@ -0,0 +1,318 @@
+/*********************************************************
+* FILE NAME		:	dt_harness.c
+* VERSION		:	1.0
+* DESCRIPTION	:	Common part of the userspace tests and
+*					benchmarks, see dt_harness.h.
+*
+* CREATE DATE	:	17/10/2026
+*********************************************************/
+#include "dt_harness.h"
+#include "data_traffic_flow.h"
+#include "data_traffic_class.h"
+#include "data_traffic_sketch.h"
+#include "data_traffic_police.h"
+#include "data_traffic_port.h"
+
+unsigned int g_seed = 1;
+
+/* MAC address of host i, locally administered */
+void harness_mac(unsigned int i, unsigned char *mac_addr)
+{
+	mac_addr[0] = 0x02;
+	mac_addr[1] = 0x00;
+	mac_addr[2] = i >> 24;
+	mac_addr[3] = i >> 16;
+	mac_addr[4] = i >> 8;
+	mac_addr[5] = i;
+}
+
+/* host index of a MAC address of harness_mac */
+unsigned int harness_mac_index(const unsigned char *mac_addr)
+{
+	return (mac_addr[2] << 24) | (mac_addr[3] << 16) | (mac_addr[4] << 8) | mac_addr[5];
+}
+
+/* IPv4 address of host i, 10.x.x.x */
+unsigned int harness_ip(unsigned int i)
+{
+	return htonl(0x0a000000 | (i & 0xffffff));
+}
+
+/*************************************************************
+  Function:     harness_skb
+  Description:  build the skb of a packet between a host and a
+                remote server, data holds the headers only
+  Input:        skb, pkt, to fill
+                host, host index
+                direction, INBOUND or OUTBOUND
+                protocol, IPPROTO_TCP, IPPROTO_UDP or another
+                remote_port, port of the server
+                len, length of the IP packet
+*************************************************************/
+void harness_skb(struct sk_buff *skb, struct harness_pkt *pkt, unsigned int host,
+						unsigned int direction, unsigned int protocol,
+						unsigned short remote_port, unsigned int len)
+{
+	__be16 local_port = htons(40000 + (host & 0x3ff));
+
+	memset(pkt, 0, sizeof(*pkt));
+	pkt->iph.version = 4;
+	pkt->iph.ihl = 5;
+	pkt->iph.protocol = protocol;
+	pkt->iph.saddr = direction == OUTBOUND ? harness_ip(host) : htonl(0x08080808);
+	pkt->iph.daddr = direction == OUTBOUND ? htonl(0x08080808) : harness_ip(host);
+	/* the ports are the first 4 bytes of TCP and UDP headers alike */
+	pkt->udph.source = direction == OUTBOUND ? local_port : htons(remote_port);
+	pkt->udph.dest = direction == OUTBOUND ? htons(remote_port) : local_port;
+	pkt->tcph.doff = 5;
+
+	memset(skb, 0, sizeof(*skb));
+	skb->protocol = htons(ETH_P_IP);
+	skb->data = (unsigned char *)pkt;
+	skb->network_header = 0;
+	skb->transport_header = sizeof(struct iphdr);
+	skb->len = max_t(unsigned int, len, sizeof(*pkt));
+}
+
+/**************************************************************
+  Function:     harness_init
+  Description:  init the parts of the module the table code
+                uses, as module_init does
+  Input:        capacity, host_capacity
+                flows, flow_capacity, 0 disables the flow tier
+                rules, classifier rules, NULL for none
+**************************************************************/
+void harness_init(unsigned int capacity, unsigned int flows, const char *rules)
+{
+	srand(g_seed);
+	host_capacity = capacity;
+	flow_capacity = flows;
+
+	if (host_entry_data_init() < 0 || sketch_init() < 0 || flow_table_init() < 0) {
+		fprintf(stderr, "module init failed\n");
+		exit(2);
+	}
+	if (rules != NULL && class_rules_load(rules) < 0) {
+		fprintf(stderr, "load class rules failed\n");
+		exit(2);
+	}
+	data_traffic_timer_init();
+}
+
+/* one second of the timer, as the module timer does */
+void harness_tick(void)
+{
+	jiffies += HZ;
+	data_traffic_timer.function(data_traffic_timer.data);
+	shim_run_pending();
+}
+
+/*************************************************************
+  Function:     harness_account
+  Description:  account an IPv4 packet of a host as the hook
+                does once its bridge port is known
+  Input:        skb, pkt, the packet of harness_skb
+                mac_addr, MAC address of the host
+                direction, INBOUND or OUTBOUND
+  Return:       false if the packet is dropped by the policer
+*************************************************************/
+bool harness_account(struct sk_buff *skb, const struct harness_pkt *pkt,
+						unsigned char *mac_addr, unsigned int direction)
+{
+	struct host_entry *host = NULL;
+	unsigned int ip = direction == OUTBOUND ? pkt->iph.saddr : pkt->iph.daddr;
+	u64 mac_key = mac_to_key(mac_addr);
+	unsigned int segs = 0, len;
+
+	len = skb_wire_len(skb, &segs);
+	sketch_account(mac_key, len);
+
+	host = lookup_or_add_host_entry(mac_addr, ip, HARNESS_PORT);
+	if (host == NULL) {
+		if (unlikely(police_enabled()) && !police_packet(mac_key, skb, direction))
+			return false;
+
+		port_account(HARNESS_PORT, 0, direction, len, segs);
+		return true;
+	}
+
+	if (unlikely(ACCESS_ONCE(host->policed)) && !police_packet(mac_key, skb, direction))
+		return false;
+
+	host_update_ip(host, ip);
+	update_host_stat(host, skb, direction, HARNESS_PORT, 0);
+
+	return true;
+}
+
+/* find or record host i, as the hook does */
+struct host_entry *harness_lookup_or_add(unsigned char *mac_addr, unsigned int host)
+{
+	return lookup_or_add_host_entry(mac_addr, harness_ip(host), HARNESS_PORT);
+}
+
+/* add hosts 0 to n - 1 */
+void harness_fill(unsigned int n)
+{
+	unsigned char mac_addr[ETH_ALEN];
+	unsigned int i;
+
+	for (i = 0; i < n; i++) {
+		harness_mac(i, mac_addr);
+		add_new_host_entry(mac_addr, harness_ip(i), HARNESS_PORT);
+		shim_run_pending();
+	}
+}
+
+/* hosts of a trace: 80% of the packets go to 20% of the hosts */
+unsigned int harness_pick_host(unsigned int hosts)
+{
+	unsigned int hot = max(hosts / 5, 1U);
+
+	if (rand() % 5 != 0)
+		return rand() % hot;
+
+	return rand() % hosts;
+}
+
+/*************************************************************
+  Function:     trace_generate
+  Description:  synthetic trace over some hosts, 10000 packets
+                per second. Most of the packets are TCP to web
+                ports, the rest DNS and random UDP.
+  Input:        pkts, to store num packets
+                hosts, number of hosts
+*************************************************************/
+void trace_generate(struct trace_pkt *pkts, unsigned int num, unsigned int hosts)
+{
+	static const unsigned short tcp_ports[] = { 80, 443, 443, 443, 8080, 1935 };
+	struct trace_pkt *pkt = NULL;
+	unsigned int i, r;
+
+	srand(g_seed);
+	for (i = 0; i < num; i++) {
+		pkt = &pkts[i];
+		pkt->msec = i / 10;
+		harness_mac(harness_pick_host(hosts), pkt->mac_addr);
+		pkt->direction = rand() % 3 == 0 ? OUTBOUND : INBOUND;
+
+		r = rand() % 10;
+		if (r < 7) {
+			pkt->protocol = IPPROTO_TCP;
+			pkt->remote_port = tcp_ports[rand() % ARRAY_SIZE(tcp_ports)];
+		} else if (r == 7) {
+			pkt->protocol = IPPROTO_UDP;
+			pkt->remote_port = 53;
+		} else {
+			pkt->protocol = IPPROTO_UDP;
+			pkt->remote_port = 1024 + rand() % 60000;
+		}
+		pkt->len = pkt->direction == INBOUND ? 1500 : 64 + rand() % 200;
+	}
+}
+
+/*************************************************************
+  Function:     trace_read
+  Description:  read a trace file, see dt_harness.h
+  Input:        path, trace file
+                pkts, to store the packets, allocated here
+  Return:       number of packets
+*************************************************************/
+unsigned int trace_read(const char *path, struct trace_pkt **pkts)
+{
+	unsigned int mac[ETH_ALEN], msec, port, len, num = 0, size = 0, i;
+	char dir[8], proto[8], line[128];
+	struct trace_pkt *pkt = NULL;
+	FILE *fp = fopen(path, "r");
+
+	if (fp == NULL) {
+		perror(path);
+		exit(2);
+	}
+
+	*pkts = NULL;
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		if (sscanf(line, "%u %x:%x:%x:%x:%x:%x %7s %7s %u %u", &msec,
+				&mac[0], &mac[1], &mac[2], &mac[3], &mac[4], &mac[5],
+				dir, proto, &port, &len) != 11)
+			continue;
+
+		if (num == size) {
+			size = size != 0 ? 2 * size : 4096;
+			*pkts = realloc(*pkts, size * sizeof(**pkts));
+		}
+		pkt = &(*pkts)[num++];
+		pkt->msec = msec;
+		for (i = 0; i < ETH_ALEN; i++)
+			pkt->mac_addr[i] = mac[i];
+		pkt->direction = strcmp(dir, "up") == 0 ? OUTBOUND : INBOUND;
+		pkt->protocol = strcmp(proto, "tcp") == 0 ? IPPROTO_TCP :
+				strcmp(proto, "udp") == 0 ? IPPROTO_UDP : 0;
+		pkt->remote_port = port;
+		pkt->len = len;
+	}
+	fclose(fp);
+
+	return num;
+}
+
+void trace_write(const char *path, const struct trace_pkt *pkts, unsigned int num)
+{
+	const unsigned char *m = NULL;
+	FILE *fp = fopen(path, "w");
+	unsigned int i;
+
+	if (fp == NULL) {
+		perror(path);
+		exit(2);
+	}
+
+	for (i = 0; i < num; i++) {
+		m = pkts[i].mac_addr;
+		fprintf(fp, "%u %02x:%02x:%02x:%02x:%02x:%02x %s %s %u %u\n", pkts[i].msec,
+			m[0], m[1], m[2], m[3], m[4], m[5],
+			pkts[i].direction == OUTBOUND ? "up" : "down",
+			pkts[i].protocol == IPPROTO_TCP ? "tcp" :
+			pkts[i].protocol == IPPROTO_UDP ? "udp" : "other",
+			pkts[i].remote_port, pkts[i].len);
+	}
+	fclose(fp);
+}
+
+/*************************************************************
+  Function:     trace_replay
+  Description:  replay a trace through harness_account, the
+                timer runs once per second of trace time and
+                the pending works between packets
+  Input:        pkts, num, the trace
+                cycles, to add the cycles spent in accounting,
+                        NULL if not needed
+  Return:       seconds of trace time
+*************************************************************/
+unsigned int trace_replay(const struct trace_pkt *pkts, unsigned int num, cycles_t *cycles)
+{
+	unsigned char mac_addr[ETH_ALEN];
+	unsigned int i, seconds = 0;
+	struct harness_pkt pkt;
+	struct sk_buff skb;
+	cycles_t t;
+
+	for (i = 0; i < num; i++) {
+		while (pkts[i].msec / 1000 > seconds) {
+			harness_tick();
+			seconds++;
+		}
+
+		memcpy(mac_addr, pkts[i].mac_addr, ETH_ALEN);
+		harness_skb(&skb, &pkt, harness_mac_index(mac_addr), pkts[i].direction,
+				pkts[i].protocol, pkts[i].remote_port, pkts[i].len);
+
+		t = get_cycles();
+		harness_account(&skb, &pkt, mac_addr, pkts[i].direction);
+		if (cycles != NULL)
+			*cycles += get_cycles() - t;
+		shim_run_pending();
+	}
+
+	return seconds;
+}
@@ -0,0 +1,69 @@
+/*********************************************************
+* FILE NAME		:	dt_harness.h
+* VERSION		:	1.0
+* DESCRIPTION	:	Common part of the userspace tests and
+*					benchmarks: module init, packets, the
+*					accounting of the hook and traces.
+*
+*					A trace is one packet per line:
+*					"<msec> <MAC> <up|down> <tcp|udp|other>
+*					<remote port> <bytes>".
+*
+* CREATE DATE	:	17/10/2026
+*********************************************************/
+#ifndef _DT_HARNESS_H
+#define _DT_HARNESS_H
+
+#include "kernel_shim.h"
+#include "data_traffic_host_entry.h"
+#include "data_traffic_tbl_ops.h"
+
+/* ifindex of the bridge port of the hosts, see kernel_shim.c */
+#define HARNESS_PORT 1
+
+/* one packet of a trace */
+struct trace_pkt {
+	unsigned int msec;
+	unsigned char mac_addr[ETH_ALEN];
+	unsigned char direction;
+	unsigned char protocol;
+	unsigned short remote_port;
+	unsigned short len;
+};
+
+/* headers of a packet, the skb points to them */
+struct harness_pkt {
+	struct iphdr iph;
+	union {
+		struct tcphdr tcph;
+		struct udphdr udph;
+	};
+};
+
+/* module parameters, see module_param in kernel_shim.h */
+extern void *shim_param_batch_accounting;
+
+extern unsigned int g_seed;
+
+extern void shim_run_pending(void);
+
+extern void harness_mac(unsigned int i, unsigned char *mac_addr);
+extern unsigned int harness_ip(unsigned int i);
+extern unsigned int harness_mac_index(const unsigned char *mac_addr);
+extern void harness_skb(struct sk_buff *skb, struct harness_pkt *pkt, unsigned int host,
+						unsigned int direction, unsigned int protocol,
+						unsigned short remote_port, unsigned int len);
+extern void harness_init(unsigned int capacity, unsigned int flows, const char *rules);
+extern void harness_tick(void);
+extern bool harness_account(struct sk_buff *skb, const struct harness_pkt *pkt,
+						unsigned char *mac_addr, unsigned int direction);
+extern struct host_entry *harness_lookup_or_add(unsigned char *mac_addr, unsigned int host);
+extern void harness_fill(unsigned int n);
+extern unsigned int harness_pick_host(unsigned int hosts);
+extern void trace_generate(struct trace_pkt *pkts, unsigned int num, unsigned int hosts);
+extern unsigned int trace_read(const char *path, struct trace_pkt **pkts);
+extern void trace_write(const char *path, const struct trace_pkt *pkts, unsigned int num);
+extern unsigned int trace_replay(const struct trace_pkt *pkts, unsigned int num,
+						cycles_t *cycles);
+
+#endif
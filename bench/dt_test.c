@@ -0,0 +1,649 @@
+/*********************************************************
+* FILE NAME		:	dt_test.c
+* VERSION		:	1.0
+* DESCRIPTION	:	Behaviour checks of the table code, built in
+*					userspace against kernel_shim.h. Each test
+*					runs in its own process on a freshly
+*					initialised table, the run fails if one check
+*					of any test fails.
+*
+* CREATE DATE	:	17/10/2026
+*********************************************************/
+#include <unistd.h>
+#include <sys/wait.h>
+#include "dt_harness.h"
+#include "data_traffic_class.h"
+#include "data_traffic_police.h"
+#include "data_traffic_dump.h"
+#include "data_traffic_neigh_cache.h"
+#include "data_traffic_rate.h"
+#include "data_traffic_sketch.h"
+
+static unsigned int g_failures;
+
+#define CHECK(cond, fmt, ...) \
+	do { \
+		if (!(cond)) { \
+			g_failures++; \
+			fprintf(stderr, "  %s:%d: " fmt "\n", __FILE__, __LINE__, ##__VA_ARGS__); \
+		} \
+	} while (0)
+
+/* totals of a host expected from a trace */
+struct expected_host {
+	u64 bytes[2];
+	u64 packets[2];
+};
+
+/*************************************************************
+  Function:     test_replay_totals
+  Description:  replay a trace, each host must have the bytes
+                and packets of its packets in the trace, ethernet
+                header included. Then the hosts must all expire
+                once the traffic stops.
+*************************************************************/
+static void test_replay_totals(void)
+{
+	unsigned int hosts = 64, num = 200000, i, recorded = 0;
+	struct trace_pkt *pkts = malloc(num * sizeof(*pkts));
+	struct expected_host *expected = calloc(hosts, sizeof(*expected));
+	unsigned char mac_addr[ETH_ALEN];
+	struct host_entry *host = NULL;
+	struct host_stat stat;
+	unsigned int idx, dir;
+
+	harness_init(hosts, 0, NULL);
+	trace_generate(pkts, num, hosts);
+	for (i = 0; i < num; i++) {
+		idx = harness_mac_index(pkts[i].mac_addr);
+		dir = pkts[i].direction;
+		expected[idx].bytes[dir] += pkts[i].len + ETH_HLEN;
+		expected[idx].packets[dir]++;
+	}
+
+	trace_replay(pkts, num, NULL);
+
+	for (i = 0; i < hosts; i++) {
+		harness_mac(i, mac_addr);
+		host = hlist_find_host_by_mac(mac_addr);
+		if (expected[i].packets[INBOUND] + expected[i].packets[OUTBOUND] == 0) {
+			CHECK(host == NULL, "host %u recorded without traffic", i);
+			continue;
+		}
+		CHECK(host != NULL, "host %u not recorded", i);
+		if (host == NULL)
+			continue;
+
+		recorded++;
+		host_stat_fold(host, &stat);
+		CHECK(stat.download_total == expected[i].bytes[INBOUND],
+			"host %u download %llu bytes, expected %llu", i,
+			stat.download_total, (unsigned long long)expected[i].bytes[INBOUND]);
+		CHECK(stat.upload_total == expected[i].bytes[OUTBOUND],
+			"host %u upload %llu bytes, expected %llu", i,
+			stat.upload_total, (unsigned long long)expected[i].bytes[OUTBOUND]);
+		CHECK(stat.download_packets == expected[i].packets[INBOUND],
+			"host %u download %llu packets, expected %llu", i,
+			stat.download_packets, (unsigned long long)expected[i].packets[INBOUND]);
+		CHECK(stat.upload_packets == expected[i].packets[OUTBOUND],
+			"host %u upload %llu packets, expected %llu", i,
+			stat.upload_packets, (unsigned long long)expected[i].packets[OUTBOUND]);
+	}
+	CHECK(g_host_count == recorded, "%u hosts in table, %u recorded", g_host_count, recorded);
+
+	for (i = 0; i <= HOST_EXPIRE_TIME + 1; i++)
+		harness_tick();
+	CHECK(g_host_count == 0, "%u hosts left after %u idle seconds",
+		g_host_count, HOST_EXPIRE_TIME + 2);
+
+	free(expected);
+	free(pkts);
+}
+
+/*************************************************************
+  Function:     test_eviction
+  Description:  twice as many hosts as host_capacity, the table
+                must stay within capacity and evict the hosts not
+                used since they were recorded, not the one in use
+*************************************************************/
+static void test_eviction(void)
+{
+	unsigned int capacity = 32, i;
+	unsigned char mac_addr[ETH_ALEN];
+	struct harness_pkt pkt;
+	struct sk_buff skb;
+
+	harness_init(capacity, 0, NULL);
+	harness_fill(capacity + 1);
+	/* a host is recorded referenced, the first eviction cleared them all */
+	CHECK(g_evict_count == 1, "%lu evicted by a host over capacity", g_evict_count);
+
+	/*
+	 * one turn of the table, after that every other host is recorded
+	 * since the last pass and CLOCK can't tell host 1 from them
+	 */
+	for (i = capacity + 1; i < 2 * capacity; i++) {
+		/* host 1 is in use, it gets a second chance each time */
+		harness_mac(1, mac_addr);
+		harness_skb(&skb, &pkt, 1, INBOUND, IPPROTO_TCP, 443, 1000);
+		harness_account(&skb, &pkt, mac_addr, INBOUND);
+
+		/* the first packet evicts, the next one records the host */
+		harness_mac(i, mac_addr);
+		harness_lookup_or_add(mac_addr, i);
+		shim_run_pending();
+		harness_lookup_or_add(mac_addr, i);
+		shim_run_pending();
+
+		CHECK(g_host_count <= capacity, "%u hosts over capacity %u", g_host_count, capacity);
+		CHECK(hlist_find_host_by_mac(mac_addr) != NULL, "new host %u not recorded", i);
+	}
+
+	harness_mac(1, mac_addr);
+	CHECK(hlist_find_host_by_mac(mac_addr) != NULL, "host in use evicted");
+	/* one host evicted per host recorded over capacity, host capacity was never recorded */
+	CHECK(g_evict_count == capacity - 1, "%lu evicted, expected %u",
+		g_evict_count, capacity - 1);
+}
+
+/* cache one host at its IPv4 address, as the download path does */
+static void neigh_cache_fill(unsigned int i, struct host_entry *host)
+{
+	struct net_device *port = NULL;
+	struct in6_addr ip_addr;
+	unsigned int gen;
+
+	ipv6_addr_set_v4mapped(htonl(harness_ip(i)), &ip_addr);
+	if (neigh_cache_lookup(&ip_addr, &port, &gen) == NULL)
+		neigh_cache_update(&ip_addr, gen, host, dev_get_by_index_rcu(&init_net, HARNESS_PORT));
+}
+
+static struct host_entry *neigh_cache_hit(unsigned int i)
+{
+	struct net_device *port = NULL;
+	struct in6_addr ip_addr;
+	unsigned int gen;
+
+	ipv6_addr_set_v4mapped(htonl(harness_ip(i)), &ip_addr);
+	return neigh_cache_lookup(&ip_addr, &port, &gen);
+}
+
+/*************************************************************
+  Function:     test_neigh_cache
+  Description:  removing a host only invalidates the neighbour
+                cache slot it was cached in, the other hosts
+                still hit. A host removed before it's cached is
+                never cached.
+*************************************************************/
+static void test_neigh_cache(void)
+{
+	unsigned int hosts = 16, other;
+	unsigned char mac_addr[ETH_ALEN];
+	struct host_entry *host = NULL, *victim = NULL;
+
+	harness_init(hosts, 0, NULL);
+	harness_fill(hosts);
+
+	harness_mac(0, mac_addr);
+	host = hlist_find_host_by_mac(mac_addr);
+	neigh_cache_fill(0, host);
+	CHECK(neigh_cache_hit(0) == host, "host 0 not cached");
+
+	/* a host in another slot */
+	for (other = 1; other < hosts; other++) {
+		harness_mac(other, mac_addr);
+		victim = hlist_find_host_by_mac(mac_addr);
+		neigh_cache_fill(other, victim);
+		if (neigh_cache_hit(0) == host)
+			break;
+		neigh_cache_fill(0, host);
+	}
+	CHECK(other < hosts, "all the hosts share one slot");
+	if (other == hosts)
+		return;
+	CHECK(neigh_cache_hit(other) == victim, "host %u not cached", other);
+
+	remove_host_entry(victim);
+	CHECK(neigh_cache_hit(other) == NULL, "removed host %u still cached", other);
+	CHECK(neigh_cache_hit(0) == host, "host 0 dropped by the removal of host %u", other);
+
+	/* cached after it's unlinked, before the grace period ends */
+	neigh_cache_fill(other, victim);
+	CHECK(neigh_cache_hit(other) == NULL, "unlinked host %u cached", other);
+	shim_run_pending();
+
+	remove_host_entry(host);
+	CHECK(neigh_cache_hit(0) == NULL, "removed host 0 still cached");
+	shim_run_pending();
+}
+
+/*************************************************************
+  Function:     test_rate
+  Description:  the averages move every second without being
+                read. A host sending a steady rate for 30 seconds
+                then idle for 3 seconds must read the steady rate
+                over 60s and nothing over 1s.
+*************************************************************/
+static void test_rate(void)
+{
+	unsigned int len = 1000, per_tick = 100, i, j;
+	unsigned int wire = len + ETH_HLEN;
+	unsigned char mac_addr[ETH_ALEN];
+	struct rate_report report;
+	struct harness_pkt pkt;
+	struct sk_buff skb;
+	struct host_entry *host = NULL;
+
+	harness_init(16, 0, NULL);
+	harness_mac(1, mac_addr);
+
+	for (i = 0; i < 30; i++) {
+		for (j = 0; j < per_tick; j++) {
+			harness_skb(&skb, &pkt, 1, OUTBOUND, IPPROTO_TCP, 443, len);
+			harness_account(&skb, &pkt, mac_addr, OUTBOUND);
+		}
+		harness_tick();
+	}
+	for (i = 0; i < 3; i++)
+		harness_tick();
+
+	host = hlist_find_host_by_mac(mac_addr);
+	CHECK(host != NULL, "host not recorded");
+	if (host == NULL)
+		return;
+
+	host_rate_read(host, &report);
+	CHECK(report.bytes[OUTBOUND][0] == 0, "1s rate %u after 3 idle seconds",
+		report.bytes[OUTBOUND][0]);
+	CHECK(report.packets[OUTBOUND][0] == 0, "1s packet rate %u after 3 idle seconds",
+		report.packets[OUTBOUND][0]);
+	/* 30 busy seconds of 60, less the decay of the idle ones */
+	CHECK(report.bytes[OUTBOUND][2] > per_tick * wire / 3 &&
+		report.bytes[OUTBOUND][2] < per_tick * wire / 2,
+		"60s rate %u, sent %u per second for half the window",
+		report.bytes[OUTBOUND][2], per_tick * wire);
+	CHECK(report.bytes[INBOUND][2] == 0, "60s download rate %u without download",
+		report.bytes[INBOUND][2]);
+}
+
+/*************************************************************
+  Function:     test_police
+  Description:  a host sending 10 times its rate for 10 seconds
+                must get rate * 10 s plus the burst, within one
+                packet, and the other direction is not limited.
+                The sketch counts the packets dropped too.
+*************************************************************/
+static void test_police(void)
+{
+	unsigned int rate = 100000, burst = 10000, seconds = 10, i, j;
+	unsigned char mac_addr[ETH_ALEN];
+	u64 accepted[2] = { 0, 0 }, offered = 0, low, high;
+	unsigned int wire = 1000 + ETH_HLEN;
+	struct host_entry *host = NULL;
+	struct harness_pkt pkt;
+	struct sk_buff skb;
+	char rule[64];
+	int dir;
+
+	harness_init(16, 0, NULL);
+	harness_mac(1, mac_addr);
+	snprintf(rule, sizeof(rule), "02:00:00:00:00:01 0 %u %u\n", rate, burst);
+	CHECK(police_rules_write(rule) == 0, "rule rejected");
+
+	/* 10 packets of each direction per jiffy */
+	for (i = 0; i < seconds * HZ; i++) {
+		for (j = 0; j < 10; j++) {
+			for (dir = 0; dir < 2; dir++) {
+				harness_skb(&skb, &pkt, 1, dir, IPPROTO_TCP, 443, 1000);
+				if (harness_account(&skb, &pkt, mac_addr, dir))
+					accepted[dir] += wire;
+			}
+			offered += wire;
+		}
+		jiffies++;
+		shim_run_pending();
+	}
+
+	low = (u64)rate * seconds;
+	high = low + burst + 2 * wire;
+	CHECK(accepted[OUTBOUND] >= low - wire && accepted[OUTBOUND] <= high,
+		"upload %llu bytes accepted, expected %llu to %llu",
+		(unsigned long long)accepted[OUTBOUND], (unsigned long long)low,
+		(unsigned long long)high);
+	CHECK(accepted[INBOUND] == offered, "download limited, %llu of %llu bytes",
+		(unsigned long long)accepted[INBOUND], (unsigned long long)offered);
+	/* the sketch sees the packets before the policer drops them */
+	CHECK(sketch_query(mac_to_key(mac_addr)) >= 2 * offered,
+		"sketch counts %llu bytes, %llu offered",
+		(unsigned long long)sketch_query(mac_to_key(mac_addr)),
+		(unsigned long long)(2 * offered));
+
+	/* a rule removed and set again reaches the recorded entry */
+	host = hlist_find_host_by_mac(mac_addr);
+	CHECK(host != NULL && host->policed, "recorded host not policed");
+	CHECK(police_rules_write("02:00:00:00:00:01 0 0\n") == 0, "rule removal rejected");
+	CHECK(host != NULL && !host->policed, "host policed without rule");
+	CHECK(police_rules_write(rule) == 0, "rule rejected");
+	CHECK(host != NULL && host->policed, "host not policed by a new rule");
+	shim_run_pending();
+}
+
+/*************************************************************
+  Function:     test_police_mixed
+  Description:  large GSO packets alternating with small ones.
+                The time a large packet puts ahead must not make
+                the next small packet look stale and restart the
+                limit, the upload stays within rate and burst.
+*************************************************************/
+static void test_police_mixed(void)
+{
+	unsigned int rate = 100000, burst = 10000, seconds = 10, i, segs;
+	unsigned int sizes[2] = { 44 * 1448 + 52, 100 };
+	unsigned char mac_addr[ETH_ALEN];
+	u64 accepted = 0, offered = 0, high;
+	unsigned int wire, large = 0;
+	struct harness_pkt pkt;
+	struct sk_buff skb;
+	char rule[64];
+
+	harness_init(16, 0, NULL);
+	harness_mac(1, mac_addr);
+	snprintf(rule, sizeof(rule), "02:00:00:00:00:01 0 %u %u\n", rate, burst);
+	CHECK(police_rules_write(rule) == 0, "rule rejected");
+
+	for (i = 0; i < 2 * seconds * HZ; i++) {
+		harness_skb(&skb, &pkt, 1, OUTBOUND, IPPROTO_TCP, 443, sizes[i & 1]);
+		if ((i & 1) == 0) {
+			skb_shinfo(&skb)->gso_size = 1448;
+			skb_shinfo(&skb)->gso_segs = 44;
+			skb_shinfo(&skb)->gso_type = SKB_GSO_TCPV4;
+		}
+		wire = skb_wire_len(&skb, &segs);
+		large = max(large, wire);
+		if (harness_account(&skb, &pkt, mac_addr, OUTBOUND))
+			accepted += wire;
+		offered += wire;
+		/* a large and a small packet per jiffy */
+		if (i & 1) {
+			jiffies++;
+			shim_run_pending();
+		}
+	}
+
+	high = (u64)rate * seconds + burst + large;
+	CHECK(accepted <= high, "upload %llu bytes accepted of %llu offered, limit %llu",
+		(unsigned long long)accepted, (unsigned long long)offered,
+		(unsigned long long)high);
+	CHECK(accepted >= (u64)rate * seconds / 2, "upload %llu bytes accepted, rate %u",
+		(unsigned long long)accepted, rate);
+}
+
+/* index of a class name in the table in use, -1 if none */
+static int class_index(const char *name)
+{
+	struct class_table *tbl = rcu_dereference(g_class_table);
+	unsigned int i;
+
+	for (i = 0; tbl != NULL && i < tbl->num; i++) {
+		if (strcmp(tbl->name[i], name) == 0)
+			return i;
+	}
+
+	return -1;
+}
+
+/*************************************************************
+  Function:     test_class
+  Description:  the bytes of a packet go to the class of its
+                remote port and protocol, or of its local port,
+                the rest to "other". A line that is not a whole
+                rule rejects the set, no rule removes the table.
+*************************************************************/
+static void test_class(void)
+{
+	static const char rules[] =
+		"# home router\n"
+		"web tcp 443,80\n"
+		"dns udp 53\n"
+		"game any 27000-27010,27090-27100 \n";
+	static const char *const rejected[] = {
+		"web tcp 70000\n",
+		"web sctp 80\n",
+		"web tcp 1000 garbage\n",
+		"web tcp 80 443\n",
+		"web tcp 80,\n",
+		"web tcp 80-\n",
+		"web tcp 90-80\n",
+		"web tcp -80\n",
+		"web tcp\n",
+		"a_class_name_too_long tcp 80\n",
+	};
+	static const struct {
+		unsigned int protocol;
+		unsigned short port;
+		const char *class;
+	} cases[] = {
+		{ IPPROTO_TCP, 443, "web" },
+		{ IPPROTO_TCP, 80, "web" },
+		{ IPPROTO_UDP, 443, CLASS_OTHER_NAME },
+		{ IPPROTO_UDP, 53, "dns" },
+		{ IPPROTO_TCP, 53, CLASS_OTHER_NAME },
+		{ IPPROTO_TCP, 27005, "game" },
+		{ IPPROTO_TCP, 27050, CLASS_OTHER_NAME },
+		{ IPPROTO_UDP, 27100, "game" },
+		{ IPPROTO_UDP, 27101, CLASS_OTHER_NAME },
+		{ IPPROTO_TCP, 22, CLASS_OTHER_NAME },
+	};
+	u64 expected[2][HOST_CLASS_NUM], class_bytes[2][HOST_CLASS_NUM];
+	unsigned char mac_addr[ETH_ALEN];
+	struct host_entry *host = NULL;
+	struct harness_pkt pkt;
+	struct sk_buff skb;
+	unsigned int i, dir;
+	int class;
+
+	harness_init(16, 0, rules);
+	for (i = 0; i < ARRAY_SIZE(rejected); i++)
+		CHECK(class_rules_load(rejected[i]) < 0, "rule accepted: %s", rejected[i]);
+	CHECK(class_index("web") > 0 && class_index("dns") > 0 && class_index("game") > 0,
+		"classes missing after a rejected rule set");
+
+	memset(expected, 0, sizeof(expected));
+	harness_mac(1, mac_addr);
+	for (i = 0; i < ARRAY_SIZE(cases); i++) {
+		class = class_index(cases[i].class);
+		CHECK(class >= 0, "class %s not found", cases[i].class);
+		if (class < 0)
+			continue;
+
+		for (dir = 0; dir < 2; dir++) {
+			harness_skb(&skb, &pkt, 1, dir, cases[i].protocol, cases[i].port, 100 + i);
+			harness_account(&skb, &pkt, mac_addr, dir);
+			expected[dir][class] += 100 + i + ETH_HLEN;
+		}
+	}
+
+	host = hlist_find_host_by_mac(mac_addr);
+	CHECK(host != NULL, "host not recorded");
+	if (host == NULL)
+		return;
+
+	host_class_read(host, class_bytes);
+	for (dir = 0; dir < 2; dir++) {
+		for (i = 0; i < HOST_CLASS_NUM; i++)
+			CHECK(class_bytes[dir][i] == expected[dir][i],
+				"direction %u class %u: %llu bytes, expected %llu", dir, i,
+				(unsigned long long)class_bytes[dir][i],
+				(unsigned long long)expected[dir][i]);
+	}
+
+	CHECK(class_rules_load("# no rule\n\n") == 0, "empty rule set rejected");
+	CHECK(rcu_access_pointer(g_class_table) == NULL, "table kept without rule");
+	shim_run_pending();
+}
+
+/* read the dump of the hosts through its proc file */
+static size_t dump_save(char *data, size_t size)
+{
+	struct file filp = { .f_mode = FMODE_READ };
+	loff_t pos = 0;
+	ssize_t n;
+	size_t len = 0;
+
+	if (dump_proc_ops.open(NULL, &filp) != 0)
+		return 0;
+	while ((n = dump_proc_ops.read(&filp, data + len, size - len, &pos)) > 0)
+		len += n;
+	dump_proc_ops.release(NULL, &filp);
+
+	return len;
+}
+
+/* write a dump back through its proc file, in pieces as a shell does */
+static int dump_load(const char *data, size_t len)
+{
+	struct file filp = { .f_mode = FMODE_WRITE };
+	loff_t pos = 0;
+	size_t done = 0;
+	ssize_t n;
+	int ret;
+
+	ret = dump_proc_ops.open(NULL, &filp);
+	if (ret != 0)
+		return ret;
+	while (done < len) {
+		n = dump_proc_ops.write(&filp, data + done, min_t(size_t, len - done, 4096), &pos);
+		if (n <= 0) {
+			dump_proc_ops.release(NULL, &filp);
+			return n < 0 ? n : -EIO;
+		}
+		done += n;
+	}
+	if (dump_proc_ops.flush != NULL) {
+		ret = dump_proc_ops.flush(&filp, NULL);
+		if (ret != 0) {
+			dump_proc_ops.release(NULL, &filp);
+			return ret;
+		}
+	}
+
+	return dump_proc_ops.release(NULL, &filp);
+}
+
+/*************************************************************
+  Function:     test_dump_restore
+  Description:  dump the hosts, remove them all, restore the
+                dump: every host is back with its totals. A
+                dump cut short restores nothing.
+*************************************************************/
+static void test_dump_restore(void)
+{
+	unsigned int hosts = 200, num = 50000, i;
+	struct trace_pkt *pkts = malloc(num * sizeof(*pkts));
+	struct host_stat *before = calloc(hosts, sizeof(*before));
+	size_t size = 1 << 20, len;
+	char *data = malloc(size);
+	unsigned char mac_addr[ETH_ALEN];
+	struct host_entry *host = NULL, *temp = NULL;
+	struct host_stat stat;
+	unsigned int count;
+
+	harness_init(256, 0, NULL);
+	trace_generate(pkts, num, hosts);
+	trace_replay(pkts, num, NULL);
+
+	for (i = 0; i < hosts; i++) {
+		harness_mac(i, mac_addr);
+		host = hlist_find_host_by_mac(mac_addr);
+		if (host != NULL)
+			host_stat_fold(host, &before[i]);
+	}
+	count = g_host_count;
+
+	len = dump_save(data, size);
+	CHECK(len > 0, "empty dump");
+
+	list_for_each_entry_safe(host, temp, g_lru_table, lru_tbl_node)
+		remove_host_entry(host);
+	shim_run_pending();
+	CHECK(g_host_count == 0, "%u hosts left after removal", g_host_count);
+
+	/* a dump cut short is rejected as a whole */
+	dump_load(data, len - 10);
+	CHECK(g_host_count == 0, "%u hosts restored from a cut dump", g_host_count);
+
+	CHECK(dump_load(data, len) == 0, "restore failed");
+	CHECK(g_host_count == count, "%u hosts restored, %u dumped", g_host_count, count);
+
+	for (i = 0; i < hosts; i++) {
+		harness_mac(i, mac_addr);
+		host = hlist_find_host_by_mac(mac_addr);
+		if (before[i].upload_packets + before[i].download_packets == 0) {
+			CHECK(host == NULL, "host %u restored without traffic", i);
+			continue;
+		}
+		CHECK(host != NULL, "host %u not restored", i);
+		if (host == NULL)
+			continue;
+
+		host_stat_fold(host, &stat);
+		CHECK(stat.upload_total == before[i].upload_total &&
+			stat.download_total == before[i].download_total &&
+			stat.upload_packets == before[i].upload_packets &&
+			stat.download_packets == before[i].download_packets,
+			"host %u totals differ after restore", i);
+	}
+
+	free(data);
+	free(before);
+	free(pkts);
+}
+
+static const struct {
+	const char *name;
+	void (*fn)(void);
+} g_tests[] = {
+	{ "replay_totals", test_replay_totals },
+	{ "eviction", test_eviction },
+	{ "neigh_cache", test_neigh_cache },
+	{ "rate", test_rate },
+	{ "police", test_police },
+	{ "police_mixed", test_police_mixed },
+	{ "class", test_class },
+	{ "dump_restore", test_dump_restore },
+};
+
+int main(int argc, char **argv)
+{
+	unsigned int i, failed = 0;
+	int status;
+	pid_t pid;
+
+	if (argc > 1 && strcmp(argv[1], "-v") == 0)
+		shim_verbose = true;
+
+	for (i = 0; i < ARRAY_SIZE(g_tests); i++) {
+		fflush(stdout);
+		pid = fork();
+		if (pid < 0) {
+			perror("fork");
+			return 2;
+		}
+		if (pid == 0) {
+			g_tests[i].fn();
+			exit(g_failures != 0);
+		}
+
+		waitpid(pid, &status, 0);
+		if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+			printf("PASS  %s\n", g_tests[i].name);
+		} else {
+			printf("FAIL  %s\n", g_tests[i].name);
+			failed++;
+		}
+	}
+
+	printf("%u of %u tests failed\n", failed, (unsigned int)ARRAY_SIZE(g_tests));
+
+	return failed != 0;
+}
@@ -0,0 +1,172 @@
+/*********************************************************
+* FILE NAME		:	kernel_shim.c
+* VERSION		:	1.0
+* DESCRIPTION	:	Userspace runtime of kernel_shim.h, and the
+*					parts of the module the harness doesn't build:
+*					neighbour cache, debugfs counters and snapshot.
+*
+* CREATE DATE	:	17/10/2026
+*********************************************************/
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include "kernel_shim.h"
+#include "data_traffic_neigh_cache.h"
+#include "data_traffic_snapshot.h"
+#include "data_traffic_stats.h"
+
+bool shim_verbose;
+struct page shim_page;
+struct net init_net;
+unsigned long jiffies;
+
+/* ports of the bridge, ifindex is the index + 1 */
+static struct net_device g_shim_devs[] = {
+	{ "eth0.1", 1 },
+	{ "eth0.100", 2 },
+	{ "ath0", 3 },
+	{ "ath1", 4 },
+};
+
+/* callbacks and works queued until the next quiescent point */
+static struct rcu_head *g_rcu_pending;
+static struct work_struct *g_work_pending;
+
+void call_rcu(struct rcu_head *head, void (*func)(struct rcu_head *head))
+{
+	head->func = func;
+	head->next = g_rcu_pending;
+	g_rcu_pending = head;
+}
+
+/* the harness holds no reference across a quiescent point */
+void synchronize_rcu(void)
+{
+}
+
+void rcu_barrier(void)
+{
+	struct rcu_head *head = NULL;
+
+	while (g_rcu_pending != NULL) {
+		head = g_rcu_pending;
+		g_rcu_pending = head->next;
+		head->func(head);
+	}
+}
+
+bool schedule_work(struct work_struct *work)
+{
+	if (work->pending)
+		return false;
+
+	work->pending = true;
+	work->next = g_work_pending;
+	g_work_pending = work;
+
+	return true;
+}
+
+bool cancel_work_sync(struct work_struct *work)
+{
+	struct work_struct **pos = &g_work_pending;
+
+	if (!work->pending)
+		return false;
+
+	while (*pos != work)
+		pos = &(*pos)->next;
+	*pos = work->next;
+	work->pending = false;
+
+	return true;
+}
+
+/*************************************************************
+  Function:     shim_run_pending
+  Description:  quiescent point of the harness, run the RCU
+                callbacks, then the work items queued so far
+*************************************************************/
+void shim_run_pending(void)
+{
+	struct work_struct *work = NULL;
+
+	rcu_barrier();
+	while (g_work_pending != NULL) {
+		work = g_work_pending;
+		g_work_pending = work->next;
+		work->pending = false;
+		work->func(work);
+	}
+	rcu_barrier();
+}
+
+cycles_t get_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (cycles_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+/* the packet clock of the harness, HZ jiffies a second */
+ktime_t ktime_get(void)
+{
+	return (ktime_t)jiffies * (1000000000 / HZ);
+}
+
+void get_random_bytes(void *buf, int nbytes)
+{
+	unsigned char *p = buf;
+
+	while (nbytes-- > 0)
+		*p++ = rand();
+}
+
+void sort(void *base, size_t num, size_t size,
+		int (*cmp)(const void *, const void *),
+		void (*swap_fn)(void *, void *, int))
+{
+	qsort(base, num, size, cmp);
+}
+
+/* the harness sends no extension header */
+int ipv6_skip_exthdr(const struct sk_buff *skb, int start, u8 *nexthdrp,
+						__be16 *frag_offp)
+{
+	return start;
+}
+
+struct net_device *dev_get_by_index_rcu(struct net *net, int ifindex)
+{
+	if (ifindex < 1 || ifindex > (int)ARRAY_SIZE(g_shim_devs))
+		return NULL;
+
+	return &g_shim_devs[ifindex - 1];
+}
+
+struct net_device *dev_get_by_name_rcu(struct net *net, const char *name)
+{
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(g_shim_devs); i++) {
+		if (strcmp(g_shim_devs[i].name, name) == 0)
+			return &g_shim_devs[i];
+	}
+
+	return NULL;
+}
+
+struct neigh_table arp_tbl;
+
+/* module parts not built, see the Makefile */
+DEFINE_PER_CPU(struct dt_stats, g_dt_stats);
+
+void snapshot_schedule(void)
+{
+}
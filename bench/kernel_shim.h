@@ -0,0 +1,832 @@
+/*********************************************************
+* FILE NAME		:	kernel_shim.h
+* VERSION		:	1.0
+* DESCRIPTION	:	The part of the kernel API used by the table
+*					code, for a single threaded userspace build.
+*					Every kernel header the module includes is
+*					generated by the Makefile as an include of
+*					this file.
+*
+*					One CPU, no preemption: locks, RCU read side
+*					and barriers are no-ops, call_rcu and work
+*					items are queued and run by the harness, see
+*					shim_run_pending. jiffies only moves when the
+*					harness moves it.
+*
+* CREATE DATE	:	17/10/2026
+*********************************************************/
+#ifndef _KERNEL_SHIM_H
+#define _KERNEL_SHIM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <limits.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+/* types */
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+typedef u8 __u8;
+typedef u16 __u16;
+typedef u32 __u32;
+typedef u64 __u64;
+typedef u16 __be16;
+typedef u32 __be32;
+typedef u16 __sum16;
+typedef unsigned int gfp_t;
+typedef u64 cycles_t;
+typedef s64 ktime_t;
+typedef void *fl_owner_t;
+
+struct inode;
+struct seq_file;
+
+#define __rcu
+#define __percpu
+#define __user
+#define __force
+#define __read_mostly
+#define __init
+#define __exit
+#define ____cacheline_aligned_in_smp __attribute__((aligned(SMP_CACHE_BYTES)))
+#define SMP_CACHE_BYTES 64
+#define PAGE_SIZE 4096UL
+
+#define likely(x) __builtin_expect(!!(x), 1)
+#define unlikely(x) __builtin_expect(!!(x), 0)
+#define ACCESS_ONCE(x) (*(volatile __typeof__(x) *)&(x))
+#define barrier() __asm__ __volatile__("" ::: "memory")
+#define smp_wmb() barrier()
+#define smp_rmb() barrier()
+#define smp_mb() barrier()
+
+#define BUILD_BUG_ON(cond) ((void)sizeof(char[1 - 2 * !!(cond)]))
+#define BUG_ON(cond) do { if (cond) abort(); } while (0)
+#define WARN_ON(cond) ({ int __c = !!(cond); if (__c) fprintf(stderr, "WARN %s:%d\n", __FILE__, __LINE__); __c; })
+#define WARN_ON_ONCE(cond) WARN_ON(cond)
+
+#define container_of(ptr, type, member) \
+	((type *)((char *)(ptr) - offsetof(type, member)))
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+#define DIV_ROUND_UP(n, d) (((n) + (d) - 1) / (d))
+#define ALIGN(x, a) (((x) + (a) - 1) & ~((__typeof__(x))(a) - 1))
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#define min_t(type, a, b) ((type)(a) < (type)(b) ? (type)(a) : (type)(b))
+#define max_t(type, a, b) ((type)(a) > (type)(b) ? (type)(a) : (type)(b))
+#define clamp_t(type, v, lo, hi) min_t(type, max_t(type, v, lo), hi)
+#define swap(a, b) do { __typeof__(a) __t = (a); (a) = (b); (b) = __t; } while (0)
+#define IS_ENABLED(opt) 0
+#define USEC_PER_SEC 1000000L
+
+static inline unsigned int ilog2(u64 n)
+{
+	return 63 - __builtin_clzll(n);
+}
+
+static inline bool is_power_of_2(unsigned long n)
+{
+	return n != 0 && (n & (n - 1)) == 0;
+}
+
+static inline unsigned long roundup_pow_of_two(unsigned long n)
+{
+	return n <= 1 ? 1 : 1UL << (64 - __builtin_clzl(n - 1));
+}
+
+static inline u64 div_u64(u64 a, u32 b) { return a / b; }
+static inline u64 div64_u64(u64 a, u64 b) { return a / b; }
+
+/* log */
+#define KERN_ERR ""
+#define KERN_WARNING ""
+#define KERN_INFO ""
+#define KERN_DEBUG ""
+extern bool shim_verbose;
+#define printk(...) do { if (shim_verbose) fprintf(stderr, __VA_ARGS__); } while (0)
+#define printk_ratelimited(...) printk(__VA_ARGS__)
+#define pr_err(...) printk(__VA_ARGS__)
+
+struct ratelimit_state {
+	int dummy;
+};
+#define DEFINE_RATELIMIT_STATE(name, interval, burst) struct ratelimit_state name
+#define __ratelimit(state) 0
+
+/* module */
+#define THIS_MODULE NULL
+#define MODULE_PARM_DESC(name, desc)
+#define MODULE_LICENSE(license)
+#define EXPORT_SYMBOL(sym)
+/* a parameter can be set by the harness, see shim_param */
+#define module_param(name, type, perm) void *shim_param_##name = &name
+#define module_init(fn)
+#define module_exit(fn)
+
+/* atomics, single CPU */
+typedef struct {
+	int counter;
+} atomic_t;
+#define ATOMIC_INIT(i) { (i) }
+#define atomic_read(v) ((v)->counter)
+#define atomic_set(v, i) ((v)->counter = (i))
+#define atomic_inc(v) ((v)->counter++)
+#define atomic_dec(v) ((v)->counter--)
+#define atomic_inc_return(v) (++(v)->counter)
+#define atomic_dec_return(v) (--(v)->counter)
+#define atomic_add(i, v) ((v)->counter += (i))
+#define cmpxchg(ptr, old, new) __sync_val_compare_and_swap(ptr, old, new)
+
+/* bitmaps, non atomic is enough on a single CPU */
+#define BITS_PER_LONG (8 * sizeof(long))
+#define BITS_TO_LONGS(nr) DIV_ROUND_UP(nr, BITS_PER_LONG)
+#define DECLARE_BITMAP(name, bits) unsigned long name[BITS_TO_LONGS(bits)]
+#define set_bit(nr, addr) ((addr)[(nr) / BITS_PER_LONG] |= 1UL << ((nr) % BITS_PER_LONG))
+#define clear_bit(nr, addr) ((addr)[(nr) / BITS_PER_LONG] &= ~(1UL << ((nr) % BITS_PER_LONG)))
+#define test_bit(nr, addr) (((addr)[(nr) / BITS_PER_LONG] >> ((nr) % BITS_PER_LONG)) & 1)
+#define bitmap_zero(addr, bits) memset(addr, 0, BITS_TO_LONGS(bits) * sizeof(long))
+#define for_each_set_bit(bit, addr, size) \
+	for ((bit) = 0; (bit) < (size); (bit)++) \
+		if (test_bit(bit, addr))
+
+/* locks, single CPU */
+typedef struct {
+	int dummy;
+} spinlock_t;
+#define DEFINE_SPINLOCK(name) spinlock_t name
+#define spin_lock_init(l) ((void)(l))
+#define spin_lock(l) ((void)(l))
+#define spin_unlock(l) ((void)(l))
+#define spin_lock_bh(l) ((void)(l))
+#define spin_unlock_bh(l) ((void)(l))
+#define spin_lock_irqsave(l, f) ((void)(l), (f) = 0)
+#define spin_unlock_irqrestore(l, f) ((void)(l), (void)(f))
+#define local_bh_disable() do { } while (0)
+#define local_bh_enable() do { } while (0)
+#define preempt_disable() do { } while (0)
+#define preempt_enable() do { } while (0)
+#define lockdep_is_held(l) 1
+
+struct mutex {
+	int dummy;
+};
+#define DEFINE_MUTEX(name) struct mutex name
+#define mutex_lock(m) ((void)(m))
+#define mutex_unlock(m) ((void)(m))
+
+typedef struct {
+	unsigned int sequence;
+} seqcount_t;
+#define seqcount_init(s) ((s)->sequence = 0)
+#define write_seqcount_begin(s) ((s)->sequence++)
+#define write_seqcount_end(s) ((s)->sequence++)
+#define read_seqcount_begin(s) ((s)->sequence)
+#define read_seqcount_retry(s, start) ((s)->sequence != (start))
+
+struct u64_stats_sync {
+	int dummy;
+};
+#define u64_stats_init(s) ((void)(s))
+#define u64_stats_update_begin(s) ((void)(s))
+#define u64_stats_update_end(s) ((void)(s))
+static inline unsigned int u64_stats_fetch_begin_bh(const struct u64_stats_sync *s)
+{
+	return 0;
+}
+
+static inline bool u64_stats_fetch_retry_bh(const struct u64_stats_sync *s, unsigned int start)
+{
+	return start != 0;
+}
+
+/* per-CPU, one CPU */
+#define NR_CPUS 1
+#define nr_cpu_ids 1
+#define num_possible_cpus() 1
+#define num_online_cpus() 1
+#define smp_processor_id() 0
+#define numa_node_id() 0
+#define cpu_to_node(cpu) 0
+#define cpu_possible(cpu) ((cpu) == 0)
+#define for_each_possible_cpu(cpu) for ((cpu) = 0; (cpu) < 1; (cpu)++)
+#define for_each_online_cpu(cpu) for_each_possible_cpu(cpu)
+#define DEFINE_PER_CPU(type, name) __typeof__(type) name
+#define DECLARE_PER_CPU(type, name) extern __typeof__(type) name
+#define this_cpu_ptr(ptr) (ptr)
+#define per_cpu_ptr(ptr, cpu) ((void)(cpu), (ptr))
+#define per_cpu(var, cpu) (*((void)(cpu), &(var)))
+#define __this_cpu_read(var) (var)
+#define this_cpu_read(var) (var)
+#define this_cpu_inc(var) ((var)++)
+#define this_cpu_add(var, n) ((var) += (n))
+#define alloc_percpu(type) ((type *)calloc(1, sizeof(type)))
+#define free_percpu(ptr) free(ptr)
+
+/* memory */
+#define GFP_KERNEL 0
+#define GFP_ATOMIC 0
+#define __GFP_ZERO 1
+#define __GFP_NOWARN 0
+struct kmem_cache {
+	size_t size;
+};
+struct page {
+	int dummy;
+};
+extern struct page shim_page;
+#define virt_to_page(addr) ((void)(addr), &shim_page)
+#define page_to_nid(page) ((void)(page), 0)
+
+static inline void *kmalloc(size_t size, gfp_t flags)
+{
+	return (flags & __GFP_ZERO) ? calloc(1, size) : malloc(size);
+}
+#define kzalloc(size, flags) calloc(1, size)
+#define kzalloc_node(size, flags, node) calloc(1, size)
+#define kcalloc(n, size, flags) calloc(n, size)
+#define kfree(ptr) free((void *)(ptr))
+#define vmalloc(size) malloc(size)
+#define vzalloc(size) calloc(1, size)
+#define vzalloc_node(size, node) calloc(1, size)
+#define vfree(ptr) free((void *)(ptr))
+#define is_vmalloc_addr(ptr) ((void)(ptr), 0)
+#define SLAB_HWCACHE_ALIGN 0
+
+static inline struct kmem_cache *kmem_cache_create(const char *name, size_t size,
+						size_t align, unsigned long flags, void *ctor)
+{
+	struct kmem_cache *cache = malloc(sizeof(*cache));
+
+	cache->size = (size + SMP_CACHE_BYTES - 1) & ~(size_t)(SMP_CACHE_BYTES - 1);
+	return cache;
+}
+
+static inline void *kmem_cache_alloc_node(struct kmem_cache *cache, gfp_t flags, int node)
+{
+	void *p = NULL;
+
+	if (posix_memalign(&p, SMP_CACHE_BYTES, cache->size) != 0)
+		return NULL;
+	if (flags & __GFP_ZERO)
+		memset(p, 0, cache->size);
+	return p;
+}
+#define kmem_cache_zalloc(cache, flags) kmem_cache_alloc_node(cache, (flags) | __GFP_ZERO, 0)
+#define kmem_cache_free(cache, p) free(p)
+#define kmem_cache_destroy(cache) free(cache)
+
+/* lists */
+struct list_head {
+	struct list_head *next, *prev;
+};
+struct hlist_head {
+	struct hlist_node *first;
+};
+struct hlist_node {
+	struct hlist_node *next, **pprev;
+};
+
+#define LIST_HEAD_INIT(name) { &(name), &(name) }
+#define LIST_HEAD(name) struct list_head name = LIST_HEAD_INIT(name)
+
+static inline void INIT_LIST_HEAD(struct list_head *list)
+{
+	list->next = list;
+	list->prev = list;
+}
+
+static inline void __list_add(struct list_head *new, struct list_head *prev,
+						struct list_head *next)
+{
+	next->prev = new;
+	new->next = next;
+	new->prev = prev;
+	prev->next = new;
+}
+
+static inline void list_add(struct list_head *new, struct list_head *head)
+{
+	__list_add(new, head, head->next);
+}
+
+static inline void list_add_tail(struct list_head *new, struct list_head *head)
+{
+	__list_add(new, head->prev, head);
+}
+
+static inline void __list_del(struct list_head *prev, struct list_head *next)
+{
+	next->prev = prev;
+	prev->next = next;
+}
+
+static inline void list_del(struct list_head *entry)
+{
+	__list_del(entry->prev, entry->next);
+	entry->next = NULL;
+	entry->prev = NULL;
+}
+
+static inline void list_del_init(struct list_head *entry)
+{
+	__list_del(entry->prev, entry->next);
+	INIT_LIST_HEAD(entry);
+}
+
+static inline void list_move_tail(struct list_head *list, struct list_head *head)
+{
+	__list_del(list->prev, list->next);
+	list_add_tail(list, head);
+}
+
+static inline void list_replace(struct list_head *old, struct list_head *new)
+{
+	new->next = old->next;
+	new->next->prev = new;
+	new->prev = old->prev;
+	new->prev->next = new;
+}
+
+static inline int list_empty(const struct list_head *head)
+{
+	return head->next == head;
+}
+
+#define list_add_rcu list_add
+#define list_add_tail_rcu list_add_tail
+#define list_del_rcu(entry) __list_del((entry)->prev, (entry)->next)
+#define list_replace_rcu list_replace
+#define list_entry(ptr, type, member) container_of(ptr, type, member)
+#define list_first_entry(ptr, type, member) list_entry((ptr)->next, type, member)
+#define list_for_each_rcu list_for_each
+#define list_for_each(pos, head) \
+	for (pos = (head)->next; pos != (head); pos = pos->next)
+#define list_for_each_entry(pos, head, member) \
+	for (pos = list_entry((head)->next, __typeof__(*pos), member); \
+	     &pos->member != (head); \
+	     pos = list_entry(pos->member.next, __typeof__(*pos), member))
+#define list_for_each_entry_rcu list_for_each_entry
+#define list_for_each_entry_safe(pos, n, head, member) \
+	for (pos = list_entry((head)->next, __typeof__(*pos), member), \
+	     n = list_entry(pos->member.next, __typeof__(*pos), member); \
+	     &pos->member != (head); \
+	     pos = n, n = list_entry(n->member.next, __typeof__(*n), member))
+
+#define INIT_HLIST_HEAD(ptr) ((ptr)->first = NULL)
+#define INIT_HLIST_NODE(ptr) ((ptr)->next = NULL, (ptr)->pprev = NULL)
+
+static inline void hlist_add_head(struct hlist_node *n, struct hlist_head *h)
+{
+	n->next = h->first;
+	if (h->first != NULL)
+		h->first->pprev = &n->next;
+	h->first = n;
+	n->pprev = &h->first;
+}
+
+static inline void __hlist_del(struct hlist_node *n)
+{
+	*n->pprev = n->next;
+	if (n->next != NULL)
+		n->next->pprev = n->pprev;
+}
+
+static inline void hlist_del(struct hlist_node *n)
+{
+	__hlist_del(n);
+	n->next = NULL;
+	n->pprev = NULL;
+}
+
+static inline void hlist_replace_rcu(struct hlist_node *old, struct hlist_node *new)
+{
+	new->next = old->next;
+	new->pprev = old->pprev;
+	*new->pprev = new;
+	if (new->next != NULL)
+		new->next->pprev = &new->next;
+}
+
+#define hlist_add_head_rcu hlist_add_head
+#define hlist_del_rcu __hlist_del
+#define hlist_del_init_rcu(n) (__hlist_del(n), (n)->pprev = NULL)
+#define hlist_unhashed(n) ((n)->pprev == NULL)
+#define hlist_first_rcu(head) ((head)->first)
+#define hlist_next_rcu(node) ((node)->next)
+#define hlist_entry(ptr, type, member) container_of(ptr, type, member)
+#define hlist_entry_safe(ptr, type, member) \
+	({ __typeof__(ptr) ____ptr = (ptr); ____ptr ? hlist_entry(____ptr, type, member) : NULL; })
+#define hlist_for_each_entry(pos, head, member) \
+	for (pos = hlist_entry_safe((head)->first, __typeof__(*(pos)), member); \
+	     pos; \
+	     pos = hlist_entry_safe((pos)->member.next, __typeof__(*(pos)), member))
+#define hlist_for_each_entry_rcu hlist_for_each_entry
+
+/* RCU, callbacks run at the next quiescent point of the harness */
+struct rcu_head {
+	struct rcu_head *next;
+	void (*func)(struct rcu_head *head);
+};
+#define rcu_read_lock() do { } while (0)
+#define rcu_read_unlock() do { } while (0)
+#define rcu_read_lock_bh() do { } while (0)
+#define rcu_read_unlock_bh() do { } while (0)
+#define rcu_dereference(p) (p)
+#define rcu_dereference_bh(p) (p)
+#define rcu_dereference_check(p, c) (p)
+#define rcu_dereference_protected(p, c) (p)
+#define rcu_access_pointer(p) (p)
+#define rcu_assign_pointer(p, v) ((p) = (v))
+#define RCU_INIT_POINTER(p, v) ((p) = (v))
+extern void call_rcu(struct rcu_head *head, void (*func)(struct rcu_head *head));
+extern void synchronize_rcu(void);
+extern void rcu_barrier(void);
+#define kfree_rcu(ptr, member) free(ptr)
+
+/* work items, run at the next quiescent point of the harness */
+struct work_struct {
+	struct work_struct *next;
+	bool pending;
+	void (*func)(struct work_struct *work);
+};
+#define INIT_WORK(w, f) ((w)->next = NULL, (w)->pending = false, (w)->func = (f))
+#define DECLARE_WORK(name, f) struct work_struct name = { NULL, false, f }
+extern bool schedule_work(struct work_struct *work);
+#define schedule_work_on(cpu, work) schedule_work(work)
+extern bool cancel_work_sync(struct work_struct *work);
+
+/* time */
+#define HZ 100
+extern unsigned long jiffies;
+#define time_after(a, b) ((long)((b) - (a)) < 0)
+#define time_before(a, b) time_after(b, a)
+#define time_after_eq(a, b) ((long)((a) - (b)) >= 0)
+#define msecs_to_jiffies(ms) ((ms) * HZ / 1000)
+#define jiffies_to_msecs(j) ((j) * 1000 / HZ)
+extern cycles_t get_cycles(void);
+extern ktime_t ktime_get(void);
+#define ktime_to_us(t) ((t) / 1000)
+#define ktime_to_ns(t) (t)
+
+struct timer_list {
+	unsigned long expires;
+	unsigned long data;
+	void (*function)(unsigned long data);
+};
+#define init_timer(t) ((void)(t))
+#define add_timer(t) ((void)(t))
+#define mod_timer(t, e) ((t)->expires = (e))
+#define del_timer_sync(t) ((void)(t))
+
+/* files, only the fields and helpers of the binary proc files */
+typedef unsigned int fmode_t;
+#define FMODE_READ 0x1
+#define FMODE_WRITE 0x2
+
+struct file {
+	fmode_t f_mode;
+	loff_t f_pos;
+	void *private_data;
+};
+
+struct file_operations {
+	void *owner;
+	int (*open)(struct inode *inode, struct file *filp);
+	ssize_t (*read)(struct file *filp, char __user *buf, size_t count, loff_t *ppos);
+	ssize_t (*write)(struct file *filp, const char __user *buf, size_t count, loff_t *ppos);
+	loff_t (*llseek)(struct file *filp, loff_t offset, int whence);
+	int (*flush)(struct file *filp, fl_owner_t id);
+	int (*release)(struct inode *inode, struct file *filp);
+};
+#define default_llseek NULL
+
+static inline ssize_t simple_read_from_buffer(void __user *to, size_t count, loff_t *ppos,
+						const void *from, size_t available)
+{
+	loff_t pos = *ppos;
+
+	if (pos < 0)
+		return -EINVAL;
+	if ((size_t)pos >= available || count == 0)
+		return 0;
+	if (count > available - pos)
+		count = available - pos;
+	memcpy(to, (const char *)from + pos, count);
+	*ppos = pos + count;
+	return count;
+}
+
+static inline ssize_t simple_write_to_buffer(void *to, size_t available, loff_t *ppos,
+						const void __user *from, size_t count)
+{
+	loff_t pos = *ppos;
+
+	if (pos < 0)
+		return -EINVAL;
+	if ((size_t)pos >= available || count == 0)
+		return 0;
+	if (count > available - pos)
+		count = available - pos;
+	memcpy((char *)to + pos, from, count);
+	*ppos = pos + count;
+	return count;
+}
+
+/* misc */
+extern void get_random_bytes(void *buf, int nbytes);
+#define skip_spaces(s) ({ const char *__s = (s); while (*__s == ' ' || *__s == '\t') __s++; (char *)__s; })
+#define strlcpy(dst, src, size) ((void)snprintf(dst, size, "%s", src))
+
+static inline char *strchrnul(const char *s, int c)
+{
+	while (*s != '\0' && *s != c)
+		s++;
+	return (char *)s;
+}
+
+static inline u16 get_unaligned_u16(const void *p)
+{
+	u16 v;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline u32 get_unaligned_u32(const void *p)
+{
+	u32 v;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+#define get_unaligned(p) (sizeof(*(p)) == 2 ? get_unaligned_u16(p) : get_unaligned_u32(p))
+#define put_unaligned(v, p) do { __typeof__(*(p)) __v = (v); memcpy((p), &__v, sizeof(__v)); } while (0)
+
+/* jhash, same algorithm as the kernel */
+#define __jhash_rot(x, k) (((x) << (k)) | ((x) >> (32 - (k))))
+#define __jhash_mix(a, b, c) \
+{ \
+	a -= c; a ^= __jhash_rot(c, 4); c += b; \
+	b -= a; b ^= __jhash_rot(a, 6); a += c; \
+	c -= b; c ^= __jhash_rot(b, 8); b += a; \
+	a -= c; a ^= __jhash_rot(c, 16); c += b; \
+	b -= a; b ^= __jhash_rot(a, 19); a += c; \
+	c -= b; c ^= __jhash_rot(b, 4); b += a; \
+}
+#define __jhash_final(a, b, c) \
+{ \
+	c ^= b; c -= __jhash_rot(b, 14); \
+	a ^= c; a -= __jhash_rot(c, 11); \
+	b ^= a; b -= __jhash_rot(a, 25); \
+	c ^= b; c -= __jhash_rot(b, 16); \
+	a ^= c; a -= __jhash_rot(c, 4); \
+	b ^= a; b -= __jhash_rot(a, 14); \
+	c ^= b; c -= __jhash_rot(b, 24); \
+}
+#define JHASH_INITVAL 0xdeadbeef
+
+static inline u32 jhash2(const u32 *k, u32 length, u32 initval)
+{
+	u32 a, b, c;
+
+	a = b = c = JHASH_INITVAL + (length << 2) + initval;
+	while (length > 3) {
+		a += k[0];
+		b += k[1];
+		c += k[2];
+		__jhash_mix(a, b, c);
+		length -= 3;
+		k += 3;
+	}
+	switch (length) {
+	case 3: c += k[2];
+	case 2: b += k[1];
+	case 1: a += k[0];
+		__jhash_final(a, b, c);
+	case 0:
+		break;
+	}
+	return c;
+}
+
+static inline u32 jhash_3words(u32 a, u32 b, u32 c, u32 initval)
+{
+	a += JHASH_INITVAL;
+	b += JHASH_INITVAL;
+	c += initval;
+	__jhash_final(a, b, c);
+	return c;
+}
+#define jhash_2words(a, b, initval) jhash_3words(a, b, 0, initval)
+#define jhash_1word(a, initval) jhash_3words(a, 0, 0, initval)
+
+static inline u64 hash_64(u64 val, unsigned int bits)
+{
+	return (val * 0x9e37fffffffc0001ULL) >> (64 - bits);
+}
+
+static inline u32 hash_32(u32 val, unsigned int bits)
+{
+	return (val * 0x9e370001U) >> (32 - bits);
+}
+
+extern void sort(void *base, size_t num, size_t size,
+		int (*cmp)(const void *, const void *),
+		void (*swap_fn)(void *, void *, int));
+
+/* tracepoints compile to nothing */
+#define TP_PROTO(...) __VA_ARGS__
+#define TP_ARGS(...) __VA_ARGS__
+#define TRACE_EVENT(name, proto, args, tstruct, assign, print) \
+	static inline void trace_##name(proto) { }
+
+/* network */
+#define ETH_ALEN 6
+#define ETH_HLEN 14
+#define ETH_P_IP 0x0800
+#define ETH_P_IPV6 0x86DD
+#define IFNAMSIZ 16
+#define IP_OFFSET 0x1FFF
+#define IP6_OFFSET 0xFFF8
+#define NF_DROP 0
+#define NF_ACCEPT 1
+#define VLAN_VID_MASK 0x0fff
+#ifndef IPPROTO_UDPLITE
+#define IPPROTO_UDPLITE 136
+#endif
+
+struct ethhdr {
+	unsigned char h_dest[ETH_ALEN];
+	unsigned char h_source[ETH_ALEN];
+	__be16 h_proto;
+} __attribute__((packed));
+
+struct iphdr {
+	u8 ihl:4, version:4;
+	u8 tos;
+	__be16 tot_len;
+	__be16 id;
+	__be16 frag_off;
+	u8 ttl;
+	u8 protocol;
+	__sum16 check;
+	__be32 saddr;
+	__be32 daddr;
+};
+
+struct ipv6hdr {
+	u8 priority:4, version:4;
+	u8 flow_lbl[3];
+	__be16 payload_len;
+	u8 nexthdr;
+	u8 hop_limit;
+	struct in6_addr saddr;
+	struct in6_addr daddr;
+};
+
+struct tcphdr {
+	__be16 source;
+	__be16 dest;
+	__be32 seq;
+	__be32 ack_seq;
+	u16 res1:4, doff:4, flags:8;
+	__be16 window;
+	__sum16 check;
+	__be16 urg_ptr;
+};
+
+struct udphdr {
+	__be16 source;
+	__be16 dest;
+	__be16 len;
+	__sum16 check;
+};
+
+struct net_device {
+	char name[IFNAMSIZ];
+	int ifindex;
+};
+
+struct net {
+	int dummy;
+};
+extern struct net init_net;
+extern struct net_device *dev_get_by_index_rcu(struct net *net, int ifindex);
+extern struct net_device *dev_get_by_name_rcu(struct net *net, const char *name);
+
+/* notifier chains are never called back, tests call the handlers */
+#define NOTIFY_DONE 0
+#define NETDEV_DOWN 2
+#define NETDEV_CHANGEADDR 8
+#define NETDEV_UNREGISTER 6
+#define NETEVENT_NEIGH_UPDATE 1
+
+struct notifier_block {
+	int (*notifier_call)(struct notifier_block *nb, unsigned long event, void *ptr);
+};
+
+static inline int register_netevent_notifier(struct notifier_block *nb)
+{
+	return 0;
+}
+#define unregister_netevent_notifier register_netevent_notifier
+#define register_netdevice_notifier register_netevent_notifier
+#define unregister_netdevice_notifier register_netevent_notifier
+
+struct neigh_table {
+	int family;
+};
+extern struct neigh_table arp_tbl;
+
+struct neighbour {
+	struct neigh_table *tbl;
+	u8 primary_key[16];
+};
+
+#define SKB_GSO_TCPV4 (1 << 0)
+#define SKB_GSO_UDP (1 << 1)
+#define SKB_GSO_TCPV6 (1 << 4)
+
+struct skb_shared_info {
+	unsigned short gso_size;
+	unsigned short gso_segs;
+	unsigned int gso_type;
+};
+
+/* linear packet from the network header on */
+struct sk_buff {
+	unsigned int len;
+	__be16 protocol;
+	u16 vlan_tci;
+	int network_header;
+	int transport_header;
+	unsigned char *data;
+	struct skb_shared_info shinfo;
+};
+
+#define skb_shinfo(skb) (&(skb)->shinfo)
+#define skb_is_gso(skb) ((skb)->shinfo.gso_size != 0)
+#define skb_network_offset(skb) ((skb)->network_header)
+#define skb_transport_offset(skb) ((skb)->transport_header)
+#define skb_network_header_len(skb) ((skb)->transport_header - (skb)->network_header)
+#define ip_hdr(skb) ((struct iphdr *)((skb)->data + (skb)->network_header))
+#define tcp_hdr(skb) ((struct tcphdr *)((skb)->data + (skb)->transport_header))
+#define tcp_hdrlen(skb) (tcp_hdr(skb)->doff * 4)
+#define vlan_tx_tag_present(skb) ((skb)->vlan_tci != 0)
+#define vlan_tx_tag_get(skb) ((skb)->vlan_tci)
+#define is_vlan_dev(dev) 0
+#define vlan_dev_vlan_id(dev) 0
+
+static inline void *skb_header_pointer(const struct sk_buff *skb, int offset,
+						int len, void *buffer)
+{
+	if (offset < 0 || (unsigned int)(offset + len) > skb->len)
+		return NULL;
+	return skb->data + offset;
+}
+
+extern int ipv6_skip_exthdr(const struct sk_buff *skb, int start, u8 *nexthdrp,
+						__be16 *frag_offp);
+
+static inline void ipv6_addr_set_v4mapped(__be32 addr, struct in6_addr *v4mapped)
+{
+	memset(v4mapped, 0, sizeof(*v4mapped));
+	v4mapped->s6_addr[10] = 0xff;
+	v4mapped->s6_addr[11] = 0xff;
+	memcpy(&v4mapped->s6_addr[12], &addr, sizeof(addr));
+}
+
+static inline bool ipv6_addr_equal(const struct in6_addr *a1, const struct in6_addr *a2)
+{
+	return memcmp(a1, a2, sizeof(*a1)) == 0;
+}
+
+static inline u32 ipv6_addr_hash(const struct in6_addr *a)
+{
+	const u32 *w = (const u32 *)a;
+
+	return w[0] ^ w[1] ^ w[2] ^ w[3];
+}
+
+static inline bool is_valid_ether_addr(const u8 *addr)
+{
+	static const u8 zero[ETH_ALEN];
+
+	return !(addr[0] & 1) && memcmp(addr, zero, ETH_ALEN) != 0;
+}
+
+#endif
@@ -14,20 +14,41 @@
 #include <linux/init.h>
 #include <linux/netfilter.h>
 #include <linux/netfilter_ipv4.h>
+#include <linux/netfilter_ipv6.h>
+#include <linux/netfilter_bridge.h>
 #include <linux/netdevice.h>
 #include <linux/skbuff.h>
 #include <linux/if_ether.h>
+#include <linux/etherdevice.h>
+#include <linux/moduleparam.h>
 #include <linux/ip.h>
+#include <linux/ipv6.h>
 #include <net/arp.h>
+#include <net/neighbour.h>
+#include <net/ipv6.h>
+#include <net/ndisc.h>
 #include <linux/list.h>
+#include <linux/rcupdate.h>
 #include <linux/seq_file.h>
 #include <linux/timer.h>
+#include <linux/timex.h>
 #include <linux/byteorder/generic.h>
 #include <net/net_namespace.h>
 #include "data_traffic_host_entry.h"
 #include "data_traffic_tbl_ops.h"
 #include "data_traffic_proc.h"
 #include "data_traffic_timer.h"
+#include "data_traffic_neigh_cache.h"
+#include "data_traffic_snapshot.h"
+#include "data_traffic_netlink.h"
+#include "data_traffic_flow.h"
+#include "data_traffic_class.h"
+#include "data_traffic_sketch.h"
+#include "data_traffic_police.h"
+#include "data_traffic_dump.h"
+#include "data_traffic_stats.h"
+#include "data_traffic_trace.h"
+#include "data_traffic_port.h"
 
 MODULE_LICENSE("GPL");
 MODULE_DESCRIPTION("data traffic statistics module");
@@ -36,67 +57,382 @@ MODULE_ALIAS("netfilter");
 
 extern struct net_device *br_port_dev_get(struct net_device *dev, unsigned char *addr);
 
+/* where the packets are counted, see traffic_hook_select */
+static char *hook_mode = "forward";
+module_param(hook_mode, charp, 0444);
+MODULE_PARM_DESC(hook_mode, "where to count packets: forward (routed IP traffic) "
+		"or bridge (every frame on the bridge ports)");
+
+/* hooks of the selected mode */
+static struct nf_hook_ops *g_hook_ops;
+static unsigned int g_hook_num;
+
 /******************************************************************
-  Function:     traffic_count
-  Description:    HOOK function, track host MAC address, and record
-                it's data traffic count.
+  Function:     account_host
+  Description:    police a packet of the host entry, then record
+                its address and data traffic count. Called under
+                rcu_read_lock().
+  Input:        family, AF_INET or AF_INET6
+                ip_addr, address of the host in the IP header
+                port, bridge port of the host
+                vid, VLAN of the packet, 0 if untagged
+                direction, INBOUND or OUTBOUND
+  Return:       NF_DROP if the host is over its limit,
+                NF_ACCEPT otherwise
 *******************************************************************/
-unsigned int traffic_count(unsigned int hooknum,
+static inline unsigned int account_host(struct host_entry *host,
 							struct sk_buff *skb,
+							int family,
+							const void *ip_addr,
+							struct net_device *port,
+							u16 vid,
+							unsigned int direction)
+{
+	if (unlikely(ACCESS_ONCE(host->policed)) &&
+		!police_packet(host->mac_key, skb, direction))
+		return NF_DROP;
+
+	if (family == AF_INET)
+		host_update_ip(host, *(const unsigned int *)ip_addr);
+	else
+		host_update_ip6(host, ip_addr);
+	update_host_stat(host, skb, direction, port->ifindex, vid);
+
+	return NF_ACCEPT;
+}
+
+/* account the cycles spent in the hook for one packet */
+static inline void hook_done(cycles_t start, unsigned int direction, unsigned int verdict)
+{
+	u64 cycles = get_cycles() - start;
+
+	dt_stat_hook_cycles(cycles);
+	trace_data_traffic_hook(direction, verdict, cycles);
+}
+
+/**
+ * the sketch sees every packet of a known MAC, before the host table, so
+ * the hosts without entry and the packets dropped later are counted too
+ */
+static inline void sketch_packet(struct sk_buff *skb, u64 mac_key)
+{
+	unsigned int segs = 0;
+
+	sketch_account(mac_key, skb_wire_len(skb, &segs));
+}
+
+/**
+ * a host without entry, table full, is still policed by the rule of its
+ * MAC and counted by its port
+ */
+static inline unsigned int account_untracked(struct sk_buff *skb,
+							const unsigned char *mac_addr,
+							struct net_device *port, u16 vid,
+							unsigned int direction)
+{
+	u64 mac_key = mac_to_key(mac_addr);
+	unsigned int segs = 0;
+	unsigned int len;
+
+	if (unlikely(police_enabled()) && !police_packet(mac_key, skb, direction))
+		return NF_DROP;
+
+	len = skb_wire_len(skb, &segs);
+	port_account(port->ifindex, vid, direction, len, segs);
+
+	return NF_ACCEPT;
+}
+
+/******************************************************************
+  Function:     traffic_count_common
+  Description:    track host MAC address of an IPv4 or IPv6 packet,
+                and record it's data traffic count.
+  Input:        family, AF_INET or AF_INET6
+                saddr, daddr, source and destination address in
+                             the IP header of this family
+*******************************************************************/
+static unsigned int traffic_count_common(struct sk_buff *skb,
 							const struct net_device *in,
 							const struct net_device *out,
-							int (*okfn)(struct sk_buff *))
+							int family,
+							const void *saddr,
+							const void *daddr)
 {
 	struct ethhdr *mac_header = eth_hdr(skb);
-	struct iphdr *ip_header = ip_hdr(skb);
-	unsigned char *mac_addr = NULL;
-	unsigned int ip_addr = 0;
+	unsigned char mac_addr[ETH_ALEN];
+	const void *ip_addr = NULL;
+	struct in6_addr cache_key;
+	struct neigh_table *tbl = &arp_tbl;
 	const unsigned char zero_mac[ETH_ALEN] = {0};
 	struct neighbour *neighbour = NULL;
-	char *device_name = NULL;
+	struct host_entry *host = NULL;
+	struct net_device *port = NULL;
+	struct net_device *lan_dev = NULL;
 	unsigned int direction = 0;
+	unsigned int gen = 0;
+	unsigned int verdict = NF_ACCEPT;
+	u16 vid = 0;
+	cycles_t start = get_cycles();
+
+	rcu_read_lock();
 
 	if (strncmp(in->name, WAN_DEVICE_NAME, strlen(WAN_DEVICE_NAME)) == 0) {
 		/* From wan to lan, download */
 		direction = INBOUND;
-		ip_addr = htonl(ip_header->daddr);
+		ip_addr = daddr;
+		lan_dev = (struct net_device *)out;
+		if (family == AF_INET)
+			ipv6_addr_set_v4mapped(*(const __be32 *)ip_addr, &cache_key);
+		else
+			cache_key = *(const struct in6_addr *)ip_addr;
 
-		neighbour = neigh_lookup(&arp_tbl, &ip_addr, out);
+		/* steady state, skip neighbour table and bridge FDB */
+		host = neigh_cache_lookup(&cache_key, &port, &gen);
+		if (host != NULL) {
+			dt_stat_inc(DT_STAT_NEIGH_HIT);
+			sketch_packet(skb, host->mac_key);
+			goto account;
+		}
+		dt_stat_inc(DT_STAT_NEIGH_MISS);
+
+#if IS_ENABLED(CONFIG_IPV6)
+		if (family == AF_INET6)
+			tbl = &nd_tbl;
+#endif
+		neighbour = neigh_lookup(tbl, ip_addr, out);
 		if (neighbour == NULL) {
-			printk(KERN_ERR "Cannot find host according to IP: ");
-			return NF_ACCEPT;
-        }
-		mac_addr = neighbour->ha;
+			dt_error(DT_ERR_NO_NEIGH);
+			goto out;
+		}
+		neigh_ha_snapshot(mac_addr, neighbour, out);
+		neigh_release(neighbour);
 
 		/* To filter out host whose mac address is all zero */
 		if (memcmp(zero_mac, mac_addr, ETH_ALEN) == 0) {
-			return NF_DROP;
+			dt_error(DT_ERR_ZERO_MAC);
+			verdict = NF_DROP;
+			goto out;
 		}
 
-		device_name = br_port_dev_get(out, mac_addr)->name;
+		port = br_port_dev_get((struct net_device *)out, mac_addr);
 	} else {
 		/* From lan, upload */
 		direction = OUTBOUND;
-		ip_addr = htonl(ip_header->saddr);
-		mac_addr = mac_header->h_source;
-		device_name = br_port_dev_get(in, mac_addr)->name;
+		ip_addr = saddr;
+		lan_dev = (struct net_device *)in;
+		memcpy(mac_addr, mac_header->h_source, ETH_ALEN);
+		port = br_port_dev_get((struct net_device *)in, mac_addr);
 	}
 
-	add_host_entry(mac_addr, ip_addr, device_name);
-	update_host_stat(mac_addr, ip_addr, skb, direction, device_name);
+	sketch_packet(skb, mac_to_key(mac_addr));
 
-	return NF_ACCEPT;
+	if (port == NULL) {
+		dt_error(DT_ERR_NO_PORT);
+		goto out;
+	}
+	/* br_port_dev_get holds the port, it stays valid under RCU */
+	dev_put(port);
+
+	/* only one hash lookup per packet, account through the entry */
+	host = lookup_or_add_host_entry(mac_addr,
+			family == AF_INET ? *(const unsigned int *)ip_addr : 0,
+			port->ifindex);
+	if (host == NULL) {
+		dt_error(host_entry_pool_full() ? DT_ERR_POOL_EXHAUSTED : DT_ERR_NO_SPARE);
+		vid = port_vlan_id(skb, lan_dev, port);
+		verdict = account_untracked(skb, mac_addr, port, vid, direction);
+		goto out;
+	}
+
+	if (direction == INBOUND)
+		neigh_cache_update(&cache_key, gen, host, port);
+
+account:
+	vid = port_vlan_id(skb, lan_dev, port);
+	verdict = account_host(host, skb, family, ip_addr, port, vid, direction);
+
+out:
+	rcu_read_unlock();
+	hook_done(start, direction, verdict);
+
+	return verdict;
 }
 
-/* FORWARD hook, used to record the host address and data traffic count */
-static struct nf_hook_ops traffic_count_hook_ops = {
-	.hook = traffic_count,
-	.owner = THIS_MODULE,
-	.hooknum = NF_INET_FORWARD,
-	.pf = PF_INET,
-	.priority = NF_IP_PRI_FIRST,
+/******************************************************************
+  Function:     traffic_count
+  Description:    IPv4 HOOK function, track host MAC address, and
+                record it's data traffic count.
+*******************************************************************/
+unsigned int traffic_count(unsigned int hooknum,
+							struct sk_buff *skb,
+							const struct net_device *in,
+							const struct net_device *out,
+							int (*okfn)(struct sk_buff *))
+{
+	struct iphdr *ip_header = ip_hdr(skb);
+
+	return traffic_count_common(skb, in, out, AF_INET,
+				&ip_header->saddr, &ip_header->daddr);
+}
+
+#if IS_ENABLED(CONFIG_IPV6)
+/******************************************************************
+  Function:     traffic_count6
+  Description:    IPv6 HOOK function, hosts share the MAC keyed
+                table with IPv4.
+*******************************************************************/
+unsigned int traffic_count6(unsigned int hooknum,
+							struct sk_buff *skb,
+							const struct net_device *in,
+							const struct net_device *out,
+							int (*okfn)(struct sk_buff *))
+{
+	struct ipv6hdr *ip6_header = ipv6_hdr(skb);
+
+	return traffic_count_common(skb, in, out, AF_INET6,
+				&ip6_header->saddr, &ip6_header->daddr);
+}
+#endif
+
+/******************************************************************
+  Function:     traffic_count_bridge
+  Description:    bridge HOOK function. Frames are counted when they
+                enter a bridge port (upload, source MAC) and when
+                they leave it (download, destination MAC), so the
+                port is known without ARP table nor FDB lookup, and
+                bridged traffic between LAN hosts is counted too.
+*******************************************************************/
+unsigned int traffic_count_bridge(unsigned int hooknum,
+							struct sk_buff *skb,
+							const struct net_device *in,
+							const struct net_device *out,
+							int (*okfn)(struct sk_buff *))
+{
+	struct ethhdr *mac_header = eth_hdr(skb);
+	unsigned char mac_addr[ETH_ALEN];
+	struct net_device *port = NULL;
+	struct host_entry *host = NULL;
+	struct in6_addr buf;
+	const void *ip_addr = NULL;
+	unsigned int direction = 0;
+	int family = 0;
+	int offset = 0;
+	unsigned int verdict = NF_ACCEPT;
+	u16 vid = 0;
+	cycles_t start = get_cycles();
+
+	if (hooknum == NF_BR_PRE_ROUTING) {
+		/* enter from a port, upload */
+		direction = OUTBOUND;
+		memcpy(mac_addr, mac_header->h_source, ETH_ALEN);
+		port = (struct net_device *)in;
+	} else {
+		/* leave through a port, download */
+		direction = INBOUND;
+		memcpy(mac_addr, mac_header->h_dest, ETH_ALEN);
+		port = (struct net_device *)out;
+	}
+
+	/* broadcast and multicast are not the traffic of one host */
+	if (is_multicast_ether_addr(mac_addr) || is_zero_ether_addr(mac_addr))
+		return NF_ACCEPT;
+
+	switch (skb->protocol) {
+	case htons(ETH_P_IP):
+		family = AF_INET;
+		offset = direction == OUTBOUND ? offsetof(struct iphdr, saddr) :
+						offsetof(struct iphdr, daddr);
+		ip_addr = skb_header_pointer(skb, skb_network_offset(skb) + offset,
+						sizeof(__be32), &buf);
+		break;
+	case htons(ETH_P_IPV6):
+		family = AF_INET6;
+		offset = direction == OUTBOUND ? offsetof(struct ipv6hdr, saddr) :
+						offsetof(struct ipv6hdr, daddr);
+		ip_addr = skb_header_pointer(skb, skb_network_offset(skb) + offset,
+						sizeof(struct in6_addr), &buf);
+		break;
+	}
+	if (ip_addr == NULL)
+		return NF_ACCEPT;
+
+	rcu_read_lock();
+	sketch_packet(skb, mac_to_key(mac_addr));
+	host = lookup_or_add_host_entry(mac_addr,
+			family == AF_INET ? *(const unsigned int *)ip_addr : 0,
+			port->ifindex);
+	vid = port_vlan_id(skb, port, NULL);
+	if (host != NULL) {
+		verdict = account_host(host, skb, family, ip_addr, port, vid, direction);
+	} else {
+		dt_error(host_entry_pool_full() ? DT_ERR_POOL_EXHAUSTED : DT_ERR_NO_SPARE);
+		verdict = account_untracked(skb, mac_addr, port, vid, direction);
+	}
+	rcu_read_unlock();
+	hook_done(start, direction, verdict);
+
+	return verdict;
+}
+
+/* FORWARD hooks, used to record the host address and data traffic count */
+static struct nf_hook_ops traffic_count_hook_ops[] = {
+	{
+		.hook = traffic_count,
+		.owner = THIS_MODULE,
+		.hooknum = NF_INET_FORWARD,
+		.pf = PF_INET,
+		.priority = NF_IP_PRI_FIRST,
+	},
+#if IS_ENABLED(CONFIG_IPV6)
+	{
+		.hook = traffic_count6,
+		.owner = THIS_MODULE,
+		.hooknum = NF_INET_FORWARD,
+		.pf = PF_INET6,
+		.priority = NF_IP6_PRI_FIRST,
+	},
+#endif
 };
 
+/* bridge hooks, on the way in and out of every bridge port */
+static struct nf_hook_ops traffic_count_bridge_ops[] = {
+	{
+		.hook = traffic_count_bridge,
+		.owner = THIS_MODULE,
+		.hooknum = NF_BR_PRE_ROUTING,
+		.pf = NFPROTO_BRIDGE,
+		.priority = NF_BR_PRI_FIRST,
+	},
+	{
+		.hook = traffic_count_bridge,
+		.owner = THIS_MODULE,
+		.hooknum = NF_BR_POST_ROUTING,
+		.pf = NFPROTO_BRIDGE,
+		.priority = NF_BR_PRI_FIRST,
+	},
+};
+
+/**************************************************************
+  Function:     traffic_hook_select
+  Description:  select the hooks of hook_mode parameter
+  Return:       return 0 in case of success,
+                return -EINVAL for an unknown mode
+**************************************************************/
+static int traffic_hook_select(void)
+{
+	if (strcmp(hook_mode, "forward") == 0) {
+		g_hook_ops = traffic_count_hook_ops;
+		g_hook_num = ARRAY_SIZE(traffic_count_hook_ops);
+	} else if (strcmp(hook_mode, "bridge") == 0) {
+		g_hook_ops = traffic_count_bridge_ops;
+		g_hook_num = ARRAY_SIZE(traffic_count_bridge_ops);
+	} else {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
 static struct file_operations proc_ops = {
 	.owner = THIS_MODULE,
 	.open = proc_seq_open,
@@ -105,6 +441,65 @@ static struct file_operations proc_ops = {
 	.release = seq_release,
 };
 
+static struct file_operations proc_rate_ops = {
+	.owner = THIS_MODULE,
+	.open = proc_rate_seq_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = seq_release,
+};
+
+static struct file_operations proc_flow_ops = {
+	.owner = THIS_MODULE,
+	.open = proc_flow_seq_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = seq_release_private,
+};
+
+static struct file_operations proc_class_ops = {
+	.owner = THIS_MODULE,
+	.open = proc_class_seq_open,
+	.read = seq_read,
+	.write = proc_class_write,
+	.llseek = seq_lseek,
+	.release = seq_release,
+};
+
+static struct file_operations proc_top_ops = {
+	.owner = THIS_MODULE,
+	.open = proc_top_open,
+	.read = seq_read,
+	.write = proc_top_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static struct file_operations proc_police_ops = {
+	.owner = THIS_MODULE,
+	.open = proc_police_open,
+	.read = seq_read,
+	.write = proc_police_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static struct file_operations proc_port_ops = {
+	.owner = THIS_MODULE,
+	.open = proc_port_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static struct file_operations proc_hash_ops = {
+	.owner = THIS_MODULE,
+	.open = proc_hash_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 /**************************************************************
   Function:     data_traffic_statistics_init
   Description:  Init data traffic statistics module, including
@@ -121,13 +516,50 @@ static int __init data_traffic_statistics_init(void)
 
 	printk(KERN_INFO "Init data traffic count module.\n");
 	printk(KERN_INFO "Context initial.\n");
-	host_entry_data_init();
+	if (host_entry_data_init() < 0) {
+		printk(KERN_ERR "Init host entries failed.\n");
+
+		goto exit;
+	}
+
+	printk(KERN_INFO "Register neighbour cache notifier\n");
+	if (neigh_cache_init() < 0) {
+		printk(KERN_ERR "Register neighbour cache notifier failed.\n");
+
+		goto free_host_entry;
+	}
+
+	printk(KERN_INFO "Alloc flow tables\n");
+	if (flow_table_init() < 0) {
+		printk(KERN_ERR "Alloc flow tables failed.\n");
+
+		goto unregister_neigh_cache;
+	}
+
+	printk(KERN_INFO "Alloc heavy hitter sketches\n");
+	if (sketch_init() < 0) {
+		printk(KERN_ERR "Alloc heavy hitter sketches failed.\n");
+
+		goto free_flow_table;
+	}
+
+	printk(KERN_INFO "Register %s hooks\n", hook_mode);
+	if (traffic_hook_select() < 0) {
+		printk(KERN_ERR "Unknown hook mode: %s\n", hook_mode);
 
-	printk(KERN_INFO "Register FORWARD hook\n");
-	if (nf_register_hook(&traffic_count_hook_ops) < 0) {
+		goto free_sketch;
+	}
+	if (nf_register_hooks(g_hook_ops, g_hook_num) < 0) {
 		printk(KERN_ERR "Register hook function failed.\n");
 
-		goto exit;
+		goto free_sketch;
+	}
+
+	printk(KERN_INFO "Alloc binary snapshot\n");
+	if (snapshot_init() < 0) {
+		printk(KERN_ERR "Alloc binary snapshot failed.\n");
+
+		goto unregister_hooks;
 	}
 
 	printk(KERN_INFO "Register proc file system\n");
@@ -135,17 +567,126 @@ static int __init data_traffic_statistics_init(void)
 	if (!proc_create(PROC_FILE_NAME, 0, parent, &proc_ops)) {
 		printk(KERN_ERR "Create proc file failed.\n");
 
-		goto unregister_forward_hook;
+		goto free_snapshot;
+	}
+	if (!proc_create(PROC_HASH_FILE_NAME, 0, parent, &proc_hash_ops)) {
+		printk(KERN_ERR "Create proc file failed.\n");
+
+		goto remove_proc_file;
+	}
+	if (!proc_create(PROC_SNAPSHOT_FILE_NAME, 0444, parent, &snapshot_proc_ops)) {
+		printk(KERN_ERR "Create proc file failed.\n");
+
+		goto remove_proc_hash_file;
+	}
+	if (!proc_create(PROC_RATE_FILE_NAME, 0, parent, &proc_rate_ops)) {
+		printk(KERN_ERR "Create proc file failed.\n");
+
+		goto remove_proc_snapshot_file;
+	}
+
+	if (!proc_create(PROC_FLOW_FILE_NAME, 0, parent, &proc_flow_ops)) {
+		printk(KERN_ERR "Create proc file failed.\n");
+
+		goto remove_proc_rate_file;
+	}
+
+	if (!proc_create(PROC_CLASS_FILE_NAME, 0644, parent, &proc_class_ops)) {
+		printk(KERN_ERR "Create proc file failed.\n");
+
+		goto remove_proc_flow_file;
+	}
+
+	if (!proc_create(PROC_TOP_FILE_NAME, 0644, parent, &proc_top_ops)) {
+		printk(KERN_ERR "Create proc file failed.\n");
+
+		goto remove_proc_class_file;
+	}
+
+	if (!proc_create(PROC_POLICE_FILE_NAME, 0644, parent, &proc_police_ops)) {
+		printk(KERN_ERR "Create proc file failed.\n");
+
+		goto remove_proc_top_file;
+	}
+
+	if (!proc_create(PROC_DUMP_FILE_NAME, 0600, parent, &dump_proc_ops)) {
+		printk(KERN_ERR "Create proc file failed.\n");
+
+		goto remove_proc_police_file;
+	}
+
+	if (!proc_create(PROC_PORT_FILE_NAME, 0, parent, &proc_port_ops)) {
+		printk(KERN_ERR "Create proc file failed.\n");
+
+		goto remove_proc_dump_file;
 	}
 
+	printk(KERN_INFO "Register generic netlink family\n");
+	if (data_traffic_netlink_init() < 0) {
+		printk(KERN_ERR "Register generic netlink family failed.\n");
+
+		goto remove_proc_port_file;
+	}
+
+	printk(KERN_INFO "Create debugfs statistics\n");
+	if (dt_stats_init() < 0)
+		printk(KERN_WARNING "Create debugfs statistics failed, continue without it.\n");
+
 	printk(KERN_INFO "Start timer\n");
 	data_traffic_timer_init();
 	add_timer(&data_traffic_timer);
 
 	return 0;
 
-unregister_forward_hook:
-	nf_unregister_hook(&traffic_count_hook_ops);
+remove_proc_port_file:
+	remove_proc_entry(PROC_PORT_FILE_NAME, parent);
+
+remove_proc_dump_file:
+	remove_proc_entry(PROC_DUMP_FILE_NAME, parent);
+
+remove_proc_police_file:
+	remove_proc_entry(PROC_POLICE_FILE_NAME, parent);
+
+remove_proc_top_file:
+	remove_proc_entry(PROC_TOP_FILE_NAME, parent);
+
+remove_proc_class_file:
+	remove_proc_entry(PROC_CLASS_FILE_NAME, parent);
+
+remove_proc_flow_file:
+	remove_proc_entry(PROC_FLOW_FILE_NAME, parent);
+
+remove_proc_rate_file:
+	remove_proc_entry(PROC_RATE_FILE_NAME, parent);
+
+remove_proc_snapshot_file:
+	remove_proc_entry(PROC_SNAPSHOT_FILE_NAME, parent);
+
+remove_proc_hash_file:
+	remove_proc_entry(PROC_HASH_FILE_NAME, parent);
+
+remove_proc_file:
+	remove_proc_entry(PROC_FILE_NAME, parent);
+
+free_snapshot:
+	snapshot_exit();
+
+unregister_hooks:
+	nf_unregister_hooks(g_hook_ops, g_hook_num);
+
+free_sketch:
+	police_exit();
+	sketch_exit();
+
+free_flow_table:
+	class_table_exit();
+	flow_table_exit();
+
+unregister_neigh_cache:
+	neigh_cache_exit();
+
+free_host_entry:
+	host_entry_data_exit();
 
 exit:
 	return -1;
@@ -163,13 +704,45 @@ static void __exit data_traffic_statistics_exit(void)
 	printk(KERN_INFO "Prepare to clean up data traffic module.\n");
 
 	printk(KERN_INFO "Delete timer\n");
-	del_timer(&data_traffic_timer);
+	data_traffic_timer_exit();
+
+	printk(KERN_INFO "Remove debugfs statistics\n");
+	dt_stats_exit();
+
+	printk(KERN_INFO "Unregister generic netlink family\n");
+	data_traffic_netlink_exit();
 
 	printk(KERN_INFO "Remove proc entry: data_traffic\n");
-	remove_proc_entry(PROC_FILE_NAME, NULL);
+	remove_proc_entry(PROC_PORT_FILE_NAME, init_net.proc_net);
+	remove_proc_entry(PROC_DUMP_FILE_NAME, init_net.proc_net);
+	remove_proc_entry(PROC_POLICE_FILE_NAME, init_net.proc_net);
+	remove_proc_entry(PROC_TOP_FILE_NAME, init_net.proc_net);
+	remove_proc_entry(PROC_CLASS_FILE_NAME, init_net.proc_net);
+	remove_proc_entry(PROC_FLOW_FILE_NAME, init_net.proc_net);
+	remove_proc_entry(PROC_RATE_FILE_NAME, init_net.proc_net);
+	remove_proc_entry(PROC_SNAPSHOT_FILE_NAME, init_net.proc_net);
+	remove_proc_entry(PROC_HASH_FILE_NAME, init_net.proc_net);
+	remove_proc_entry(PROC_FILE_NAME, init_net.proc_net);
+
+	printk(KERN_INFO "Unregister %s hooks\n", hook_mode);
+	nf_unregister_hooks(g_hook_ops, g_hook_num);
+
+	printk(KERN_INFO "Free binary snapshot\n");
+	snapshot_exit();
+
+	printk(KERN_INFO "Free policer rules and heavy hitter sketches\n");
+	police_exit();
+	sketch_exit();
+
+	printk(KERN_INFO "Free flow tables and class rules\n");
+	class_table_exit();
+	flow_table_exit();
+
+	printk(KERN_INFO "Unregister neighbour cache notifier\n");
+	neigh_cache_exit();
 
-	printk(KERN_INFO "Unregister FORWARD hook\n");
-	nf_unregister_hook(&traffic_count_hook_ops);
+	printk(KERN_INFO "Free host entries\n");
+	host_entry_data_exit();
 }
 
 module_init(data_traffic_statistics_init);
@@ -0,0 +1,268 @@
+/*********************************************************
+* FILE NAME		:	data_traffic_class.c
+* VERSION		:	1.0
+* DESCRIPTION	:	Compile the port rules of traffic classes.
+*
+*					A rule is one line: "<class> <tcp|udp|any>
+*					<port>[-<port>][,<port>[-<port>]...]". Writing
+*					the rules replaces all of them, the new table is
+*					published with RCU, no table at all if there is
+*					no rule. The class names are compiled into the
+*					table, a rejected set of rules changes nothing.
+*					A class named in the rules in use keeps its
+*					index, so that the per-host counters keep their
+*					meaning across reloads of the rules. An index
+*					freed by a reload is given to a new class last,
+*					its counters keep the bytes of the old class.
+*
+* CREATE DATE	:	17/10/2026
+*********************************************************/
+#include <linux/kernel.h>
+#include <linux/ctype.h>
+#include <linux/string.h>
+#include <linux/mutex.h>
+#include <linux/vmalloc.h>
+#include <linux/rcupdate.h>
+#include <linux/in.h>
+#include "data_traffic_class.h"
+
+struct class_table __rcu *g_class_table;
+
+/* serializes the writers */
+static DEFINE_MUTEX(g_class_mutex);
+
+/* index of a class name in a table, -1 if it's not there */
+static int class_find(const struct class_table *tbl, const char *name)
+{
+	unsigned int i;
+
+	for (i = 0; i < tbl->num; i++) {
+		if (tbl->name[i][0] != '\0' && strcmp(tbl->name[i], name) == 0)
+			return i;
+	}
+
+	return -1;
+}
+
+/*************************************************************
+  Function:     class_find_or_add
+  Description:  index of a class name in the table being
+                compiled. A new name takes its index in the
+                table in use if it's free, else the first index
+                free in both tables, else the first free one.
+                Called with g_class_mutex held.
+  Input:        tbl, table being compiled
+                old, table in use, may be NULL
+                name, class name
+  Return:       class index, -ENOSPC if all the classes are used
+*************************************************************/
+static int class_find_or_add(struct class_table *tbl, const struct class_table *old,
+						const char *name)
+{
+	int class = class_find(tbl, name);
+	int i;
+
+	if (class >= 0)
+		return class;
+
+	if (old != NULL)
+		class = class_find(old, name);
+	if (class < 0 || tbl->name[class][0] != '\0') {
+		class = -1;
+		for (i = 0; i < CLASS_NUM; i++) {
+			if (tbl->name[i][0] != '\0')
+				continue;
+			if (old == NULL || i >= old->num || old->name[i][0] == '\0') {
+				class = i;
+				break;
+			}
+			if (class < 0)
+				class = i;
+		}
+		if (class < 0)
+			return -ENOSPC;
+	}
+
+	strlcpy(tbl->name[class], name, CLASS_NAME_LEN);
+	tbl->num = max_t(unsigned int, tbl->num, class + 1);
+
+	return class;
+}
+
+/* parse a port number, return the text after it, NULL if it's not a port */
+static const char *class_port_parse(const char *s, unsigned int *port)
+{
+	unsigned int value = 0;
+
+	if (!isdigit(*s))
+		return NULL;
+
+	while (isdigit(*s)) {
+		value = value * 10 + (*s++ - '0');
+		if (value >= CLASS_PORT_NUM)
+			return NULL;
+	}
+	*port = value;
+
+	return s;
+}
+
+/* parse one word of at most len - 1 characters, return the text after it */
+static const char *class_word_parse(const char *s, char *word, size_t len)
+{
+	size_t n = 0;
+
+	while (s[n] != '\0' && !isspace(s[n]))
+		n++;
+	if (n == 0 || n >= len)
+		return NULL;
+
+	memcpy(word, s, n);
+	word[n] = '\0';
+
+	return skip_spaces(s + n);
+}
+
+/*************************************************************
+  Function:     class_rule_compile
+  Description:  parse one rule and set its ports in the table.
+                The whole line must be a rule, a rule set is
+                rejected rather than loaded in part. Called with
+                g_class_mutex held.
+  Input:        tbl, table being compiled
+                old, table in use, may be NULL
+                line, the rule, NUL terminated
+  Return:       return 0 in case of success, 1 for a blank or
+                comment line, negative error code otherwise
+*************************************************************/
+static int class_rule_compile(struct class_table *tbl, const struct class_table *old,
+						const char *line)
+{
+	char name[CLASS_NAME_LEN], proto[8];
+	unsigned int low = 0, high = 0, port;
+	const char *s = skip_spaces(line);
+	int class;
+
+	if (*s == '\0' || *s == '#')
+		return 1;
+
+	s = class_word_parse(s, name, sizeof(name));
+	if (s == NULL)
+		return -EINVAL;
+	s = class_word_parse(s, proto, sizeof(proto));
+	if (s == NULL)
+		return -EINVAL;
+	if (strcmp(proto, "tcp") != 0 && strcmp(proto, "udp") != 0 &&
+		strcmp(proto, "any") != 0)
+		return -EINVAL;
+
+	class = class_find_or_add(tbl, old, name);
+	if (class < 0)
+		return class;
+
+	for (;;) {
+		s = class_port_parse(s, &low);
+		if (s == NULL)
+			return -EINVAL;
+		high = low;
+		if (*s == '-') {
+			s = class_port_parse(s + 1, &high);
+			if (s == NULL || low > high)
+				return -EINVAL;
+		}
+
+		for (port = low; port <= high; port++) {
+			if (strcmp(proto, "udp") != 0)
+				tbl->port[CLASS_ROW_TCP][port] = class;
+			if (strcmp(proto, "tcp") != 0)
+				tbl->port[CLASS_ROW_UDP][port] = class;
+		}
+
+		if (*s != ',')
+			break;
+		s++;
+	}
+
+	/* nothing but spaces after the last port */
+	if (*skip_spaces(s) != '\0')
+		return -EINVAL;
+
+	return 0;
+}
+
+/*************************************************************
+  Function:     class_rules_load
+  Description:  compile a set of rules and make it the one in
+                use, a set without rule removes the table. Called
+                in process context.
+  Input:        rules, one rule per line, NUL terminated
+  Return:       return 0 in case of success,
+                return -EINVAL for a malformed rule,
+                return -ENOSPC if there are too many classes,
+                return -ENOMEM if out of memory
+*************************************************************/
+int class_rules_load(const char *rules)
+{
+	struct class_table *tbl = NULL, *old = NULL;
+	char line[128];
+	const char *end = NULL;
+	unsigned int count = 0;
+	int ret = 0;
+
+	tbl = vzalloc(sizeof(*tbl));
+	if (tbl == NULL)
+		return -ENOMEM;
+
+	tbl->proto_row[IPPROTO_TCP] = CLASS_ROW_TCP;
+	tbl->proto_row[IPPROTO_UDP] = CLASS_ROW_UDP;
+	tbl->proto_row[IPPROTO_UDPLITE] = CLASS_ROW_UDP;
+	strlcpy(tbl->name[CLASS_OTHER], CLASS_OTHER_NAME, CLASS_NAME_LEN);
+	tbl->num = CLASS_OTHER + 1;
+
+	mutex_lock(&g_class_mutex);
+	old = rcu_dereference_protected(g_class_table, lockdep_is_held(&g_class_mutex));
+
+	while (*rules != '\0') {
+		end = strchrnul(rules, '\n');
+		if (end - rules >= sizeof(line)) {
+			ret = -EINVAL;
+			goto unlock;
+		}
+		memcpy(line, rules, end - rules);
+		line[end - rules] = '\0';
+		rules = *end == '\0' ? end : end + 1;
+
+		ret = class_rule_compile(tbl, old, line);
+		if (ret < 0)
+			goto unlock;
+		if (ret == 0)
+			count++;
+	}
+	ret = 0;
+
+	/* without rule the packet path doesn't parse L4 for the classes */
+	if (count == 0) {
+		vfree(tbl);
+		tbl = NULL;
+	}
+	rcu_assign_pointer(g_class_table, tbl);
+	tbl = old;
+
+unlock:
+	mutex_unlock(&g_class_mutex);
+
+	/* the old table, or the new one if it's rejected */
+	if (tbl != NULL) {
+		synchronize_rcu();
+		vfree(tbl);
+	}
+
+	return ret;
+}
+
+/* free the rules, called once the hooks are unregistered */
+void class_table_exit(void)
+{
+	vfree(rcu_dereference_protected(g_class_table, 1));
+	RCU_INIT_POINTER(g_class_table, NULL);
+}
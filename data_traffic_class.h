@@ -0,0 +1,72 @@
+/*********************************************************
+* FILE NAME		:	data_traffic_class.h
+* VERSION		:	1.0
+* DESCRIPTION	:	Traffic classes of a host, such as web, video
+*					and DNS. Port rules written at runtime are
+*					compiled into a direct indexed table, looked
+*					up by the packet path under RCU.
+*
+* CREATE DATE	:	17/10/2026
+*********************************************************/
+#ifndef _DATA_TRAFFIC_CLASS_H
+#define _DATA_TRAFFIC_CLASS_H
+
+#include <linux/types.h>
+#include <linux/rcupdate.h>
+#include <linux/bug.h>
+#include "data_traffic_flow.h"
+
+/* class 0 is "other", for the traffic no rule matches */
+#define CLASS_NUM 8
+#define CLASS_OTHER 0
+#define CLASS_OTHER_NAME "other"
+#define CLASS_NAME_LEN 16
+#define CLASS_PORT_NUM 65536
+
+/* rows of the port table, a protocol without rule uses the empty row */
+#define CLASS_ROW_NONE 0
+#define CLASS_ROW_TCP 1
+#define CLASS_ROW_UDP 2
+#define CLASS_ROW_NUM 3
+
+/**
+ * compiled rules, replaced as a whole. The class of a port is
+ * port[proto_row[protocol]][port], the names are kept with the
+ * table so that readers see the names of the rules in use. An
+ * index below num with an empty name is not used.
+ */
+struct class_table {
+	unsigned int num;
+	char name[CLASS_NUM][CLASS_NAME_LEN];
+	u8 proto_row[256];
+	u8 port[CLASS_ROW_NUM][CLASS_PORT_NUM];
+};
+
+extern struct class_table __rcu *g_class_table;
+
+/*************************************************************
+  Function:     class_lookup
+  Description:  class of a flow, by the remote port first, then
+                the local port for a host acting as a server.
+                Called under rcu_read_lock().
+  Return:       class index, CLASS_OTHER if no rule matches
+*************************************************************/
+static inline unsigned int class_lookup(const struct flow_tuple *tuple)
+{
+	struct class_table *tbl = rcu_dereference(g_class_table);
+	const u8 *row = NULL;
+	unsigned int class;
+
+	if (tbl == NULL)
+		return CLASS_OTHER;
+
+	row = tbl->port[tbl->proto_row[tuple->protocol]];
+	class = row[ntohs(tuple->remote_port)];
+
+	return class != CLASS_OTHER ? class : row[ntohs(tuple->local_port)];
+}
+
+extern int class_rules_load(const char *rules);
+extern void class_table_exit(void);
+
+#endif
@@ -0,0 +1,227 @@
+/*********************************************************
+* FILE NAME		:	data_traffic_dump.c
+* VERSION		:	1.0
+* DESCRIPTION	:	Binary dump and restore of the host totals.
+*
+*					Reading the proc file returns a dump of all
+*					the hosts, taken when it's opened. Writing a
+*					dump back to it restores the hosts as soon as
+*					the last record is written, in a single pass
+*					over the records, and the write reports a
+*					malformed dump or a full table. A host already
+*					recorded is not restored, so the dump is best
+*					written right after the module is loaded, and
+*					writing it twice changes nothing. A script saves
+*					the dump before the module is unloaded or the
+*					router reboots, and writes it back after the
+*					module is loaded.
+*
+* CREATE DATE	:	17/10/2026
+*********************************************************/
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/fs.h>
+#include <linux/vmalloc.h>
+#include <linux/rculist.h>
+#include <linux/uaccess.h>
+#include <linux/string.h>
+#include <linux/etherdevice.h>
+#include "data_traffic_dump.h"
+#include "data_traffic_host_entry.h"
+#include "data_traffic_tbl_ops.h"
+
+/* dump being read or written through one open file */
+struct dump_buffer {
+	size_t len;
+	size_t size;
+	/* set once a written dump is restored */
+	bool restored;
+	char data[0];
+};
+
+static inline struct dt_dump_header *dump_header(struct dump_buffer *buf)
+{
+	return (struct dt_dump_header *)buf->data;
+}
+
+static inline struct dt_host_record *dump_records(struct dump_buffer *buf)
+{
+	return (struct dt_host_record *)(buf->data + sizeof(struct dt_dump_header));
+}
+
+/*************************************************************
+  Function:     dump_open
+  Description:  a reader gets the dump of all the hosts now, a
+                writer gets a buffer for host_capacity records.
+                Reading and writing at once is not supported.
+*************************************************************/
+static int dump_open(struct inode *inode, struct file *filp)
+{
+	struct dump_buffer *buf = NULL;
+	struct dt_dump_header *header = NULL;
+	struct host_entry *host = NULL;
+	size_t size = sizeof(*header) + host_capacity * sizeof(struct dt_host_record);
+	unsigned int count = 0;
+
+	if ((filp->f_mode & FMODE_READ) && (filp->f_mode & FMODE_WRITE))
+		return -EINVAL;
+
+	buf = vzalloc(sizeof(*buf) + size);
+	if (buf == NULL)
+		return -ENOMEM;
+	buf->size = size;
+
+	if (filp->f_mode & FMODE_READ) {
+		rcu_read_lock();
+		list_for_each_entry_rcu(host, g_lru_table, lru_tbl_node) {
+			if (count == host_capacity)
+				break;
+			host_entry_to_record(host, &dump_records(buf)[count++]);
+		}
+		rcu_read_unlock();
+
+		header = dump_header(buf);
+		header->magic = DT_DUMP_MAGIC;
+		header->version = DT_DUMP_VERSION;
+		header->record_size = sizeof(struct dt_host_record);
+		header->count = count;
+		buf->len = sizeof(*header) + count * sizeof(struct dt_host_record);
+	}
+
+	filp->private_data = buf;
+
+	return 0;
+}
+
+static ssize_t dump_read(struct file *filp, char __user *ubuf,
+						size_t count, loff_t *ppos)
+{
+	struct dump_buffer *buf = filp->private_data;
+
+	return simple_read_from_buffer(ubuf, count, ppos, buf->data, buf->len);
+}
+
+/* length of the dump announced by a complete header */
+static inline size_t dump_len(const struct dt_dump_header *header)
+{
+	return sizeof(*header) + (size_t)header->count * sizeof(struct dt_host_record);
+}
+
+/*************************************************************
+  Function:     dump_check
+  Description:  check the header of the dump being written, and
+                its records once they are all written
+  Input:        buf, dump with a complete header
+  Return:       return 0 if it's valid so far,
+                return -EINVAL for a malformed dump,
+                return -EFBIG for more hosts than host_capacity
+*************************************************************/
+static int dump_check(struct dump_buffer *buf)
+{
+	struct dt_dump_header *header = dump_header(buf);
+	struct dt_host_record *rec = dump_records(buf);
+	unsigned int i;
+
+	if (header->magic != DT_DUMP_MAGIC || header->version != DT_DUMP_VERSION ||
+		header->record_size != sizeof(struct dt_host_record))
+		return -EINVAL;
+	if (header->count > host_capacity)
+		return -EFBIG;
+	if (buf->len != dump_len(header))
+		return buf->len < dump_len(header) ? 0 : -EINVAL;
+
+	/* the packet path never records a multicast or zero MAC */
+	for (i = 0; i < header->count; i++) {
+		if (!is_valid_ether_addr(rec[i].mac_addr) ||
+			memchr(rec[i].access_device_name, '\0', DT_DEVICE_NAME_LEN) == NULL)
+			return -EINVAL;
+	}
+
+	return 0;
+}
+
+/*************************************************************
+  Function:     dump_write
+  Description:  append to the dump being written. The dump is
+                checked as it comes, and restored once its last
+                record is written.
+  Return:       count in case of success,
+                return -EINVAL for a malformed dump,
+                return -EFBIG for more hosts than host_capacity,
+                return -ENOSPC if the table is full before all
+                the hosts are restored
+*************************************************************/
+static ssize_t dump_write(struct file *filp, const char __user *ubuf,
+						size_t count, loff_t *ppos)
+{
+	struct dump_buffer *buf = filp->private_data;
+	struct dt_dump_header *header = dump_header(buf);
+	unsigned int done, restored;
+	ssize_t ret;
+
+	if (*ppos != buf->len || buf->restored)
+		return -EINVAL;
+
+	ret = simple_write_to_buffer(buf->data, buf->size, ppos, ubuf, count);
+	if (ret < 0)
+		return ret;
+	if (ret < count)
+		return -EFBIG;
+	buf->len = *ppos;
+
+	if (buf->len < sizeof(*header))
+		return ret;
+
+	ret = dump_check(buf);
+	if (ret < 0)
+		return ret;
+	if (buf->len < dump_len(header))
+		return count;
+
+	buf->restored = true;
+	done = restore_host_entries(dump_records(buf), header->count, &restored);
+	printk(KERN_INFO "Restore dump, %u of %u hosts restored, %u already recorded.\n",
+			restored, header->count, done - restored);
+	if (done < header->count)
+		return -ENOSPC;
+
+	return count;
+}
+
+/*************************************************************
+  Function:     dump_flush
+  Description:  report a dump closed before its last record,
+                close() returns the error
+*************************************************************/
+static int dump_flush(struct file *filp, fl_owner_t id)
+{
+	struct dump_buffer *buf = filp->private_data;
+
+	if ((filp->f_mode & FMODE_WRITE) && buf->len != 0 && !buf->restored)
+		return -EINVAL;
+
+	return 0;
+}
+
+/* free the buffer of this file */
+static int dump_release(struct inode *inode, struct file *filp)
+{
+	struct dump_buffer *buf = filp->private_data;
+
+	if ((filp->f_mode & FMODE_WRITE) && buf->len != 0 && !buf->restored)
+		printk(KERN_ERR "Restore dump failed, truncated dump.\n");
+
+	vfree(buf);
+
+	return 0;
+}
+
+const struct file_operations dump_proc_ops = {
+	.owner = THIS_MODULE,
+	.open = dump_open,
+	.read = dump_read,
+	.write = dump_write,
+	.llseek = default_llseek,
+	.flush = dump_flush,
+	.release = dump_release,
+};
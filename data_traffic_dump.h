@@ -0,0 +1,19 @@
+/*********************************************************
+* FILE NAME		:	data_traffic_dump.h
+* VERSION		:	1.0
+* DESCRIPTION	:	Binary dump and restore of the host totals
+*					through a proc file.
+*
+* CREATE DATE	:	17/10/2026
+*********************************************************/
+#ifndef _DATA_TRAFFIC_DUMP_H
+#define _DATA_TRAFFIC_DUMP_H
+
+#include <linux/fs.h>
+#include "data_traffic_export.h"
+
+#define PROC_DUMP_FILE_NAME "statistics_dump"
+
+extern const struct file_operations dump_proc_ops;
+
+#endif
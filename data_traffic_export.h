@@ -0,0 +1,136 @@
+/*********************************************************
+* FILE NAME		:	data_traffic_export.h
+* VERSION		:	1.0
+* DESCRIPTION	:	Binary layout of the host statistics shared
+*					with userspace. Fixed size, little or big
+*					endian as the router, IP address in network
+*					byte order. Bump DT_SNAPSHOT_VERSION on any
+*					change.
+*
+* CREATE DATE	:	17/10/2026
+*********************************************************/
+#ifndef _DATA_TRAFFIC_EXPORT_H
+#define _DATA_TRAFFIC_EXPORT_H
+
+#include <linux/types.h>
+
+#define DT_SNAPSHOT_MAGIC 0x44545353	/* "DTSS" */
+#define DT_SNAPSHOT_VERSION 2
+/* IFNAMSIZ, a port name always fits with its NUL */
+#define DT_DEVICE_NAME_LEN 16
+#define DT_DUMP_MAGIC 0x44544450	/* "DTDP" */
+#define DT_DUMP_VERSION 2
+
+/* one host, 72 bytes */
+struct dt_host_record {
+	__u8 mac_addr[6];
+	__u8 pad[2];
+	char access_device_name[DT_DEVICE_NAME_LEN];
+	__u32 ip_addr;
+	__u32 upload_speed;
+	__u32 download_speed;
+	__u32 reserved;
+	__u64 upload_total;
+	__u64 download_total;
+	__u64 upload_packets;
+	__u64 download_packets;
+};
+
+/**
+ * one flow of a host, 80 bytes. The local address and port are on the
+ * host side, IPv4 addresses are IPv4-mapped, ports in network byte order.
+ * A flow counted on several CPUs is reported once per CPU, sum them up.
+ */
+struct dt_flow_record {
+	__u8 mac_addr[6];
+	__u8 protocol;
+	__u8 family;
+	__u8 local_addr[16];
+	__u8 remote_addr[16];
+	__u16 local_port;
+	__u16 remote_port;
+	__u32 reserved;
+	__u64 upload_bytes;
+	__u64 download_bytes;
+	__u64 upload_packets;
+	__u64 download_packets;
+};
+
+/**
+ * One of the two snapshot buffers. seq is odd while the buffer is being
+ * written, a reader retries if seq is odd or changed after the copy.
+ */
+struct dt_snapshot_buffer {
+	__u32 seq;
+	__u32 count;
+	__u64 timestamp_ms;
+	struct dt_host_record records[0];
+};
+
+/**
+ * First page of the mapping. The kernel fills the inactive buffer every
+ * second, then makes it the active one.
+ */
+struct dt_snapshot_header {
+	__u32 magic;
+	__u32 version;
+	__u32 record_size;
+	__u32 max_records;
+	__u32 buffer_offset[2];
+	__u32 active;
+	__u32 seq;
+};
+
+/**
+ * Dump of all the hosts, read from the dump proc file and written back
+ * to it to restore the totals, after a module reload or a reboot.
+ * The header is followed by count records.
+ */
+struct dt_dump_header {
+	__u32 magic;
+	__u32 version;
+	__u32 record_size;
+	__u32 count;
+};
+
+/**
+ * Generic netlink family, all the commands need CAP_NET_ADMIN since the
+ * replies tell the addresses and traffic of every LAN host.
+ *
+ * DT_CMD_GET_HOST with DT_ATTR_MAC returns one host, as a dump it returns
+ * all the hosts, or with DT_ATTR_SINCE_GEN only the hosts which had
+ * traffic since that generation. A delta dump starts with a
+ * DT_CMD_DEL_HOST message for each host removed since that generation.
+ * If the kernel no longer remembers all of them, the dump starts with a
+ * DT_ATTR_RESYNC message instead and carries all the hosts, the hosts not
+ * in it are gone. Every reply carries the DT_ATTR_GENERATION to pass in
+ * the next delta dump. The hosts of a dump are the ones recorded when it
+ * starts, a multi-part dump neither repeats nor skips any of them.
+ * DT_CMD_GET_FLOW dumps the flows, one DT_ATTR_FLOW per message.
+ */
+#define DT_GENL_NAME "DATA_TRAFFIC"
+#define DT_GENL_VERSION 3
+
+enum {
+	DT_CMD_UNSPEC,
+	DT_CMD_GET_HOST,
+	DT_CMD_GET_FLOW,	/* dump only */
+	DT_CMD_DEL_HOST,	/* reply only, a removed host */
+	__DT_CMD_MAX,
+};
+#define DT_CMD_MAX (__DT_CMD_MAX - 1)
+
+enum {
+	DT_ATTR_UNSPEC,
+	DT_ATTR_MAC,		/* binary, 6 bytes */
+	DT_ATTR_SINCE_GEN,	/* u32 */
+	DT_ATTR_GENERATION,	/* u32 */
+	DT_ATTR_RECORD,		/* binary, struct dt_host_record */
+	DT_ATTR_IP6,		/* binary, 16 bytes, once per IPv6 address */
+	DT_ATTR_FLOW,		/* binary, struct dt_flow_record */
+	DT_ATTR_RESYNC,		/* flag, drop the hosts not in this dump */
+	__DT_ATTR_MAX,
+};
+#define DT_ATTR_MAX (__DT_ATTR_MAX - 1)
+
+#endif
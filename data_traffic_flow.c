@@ -0,0 +1,303 @@
+/*********************************************************
+* FILE NAME		:	data_traffic_flow.c
+* VERSION		:	1.0
+* DESCRIPTION	:	Per-flow statistics under the host entries.
+*
+*					Every CPU owns a set associative table of
+*					flow_capacity flows, only written by the hook
+*					running on it, so its memory is bounded and the
+*					packet path takes no lock. A new flow replaces
+*					an idle flow of its set, or the one with the
+*					fewest bytes, so the heavy flows are kept.
+*
+* CREATE DATE	:	17/10/2026
+*********************************************************/
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/moduleparam.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/log2.h>
+#include <linux/percpu.h>
+#include <linux/cpumask.h>
+#include <linux/topology.h>
+#include <linux/jhash.h>
+#include <linux/random.h>
+#include <linux/jiffies.h>
+#include <linux/string.h>
+#include <linux/ip.h>
+#include <linux/ipv6.h>
+#include <linux/in.h>
+#include <net/ip.h>
+#include <net/ipv6.h>
+#include "data_traffic_flow.h"
+
+/* flows per CPU, 0 disables the flow statistics */
+unsigned int flow_capacity = DEFAULT_FLOW_CAPACITY;
+module_param(flow_capacity, uint, 0444);
+MODULE_PARM_DESC(flow_capacity, "max number of recorded flows per CPU, 0 to disable");
+
+static DEFINE_PER_CPU(struct flow_entry *, g_flow_table);
+
+/* number of sets of each table, power of 2 */
+static unsigned int g_flow_sets __read_mostly;
+static u32 g_flow_seed __read_mostly;
+
+/*************************************************************
+  Function:     flow_parse
+  Description:  fill the 5-tuple of a packet, the ports are left
+                0 for fragments and protocols without ports
+  Input:        skb, packet with its network header set
+                direction, INBOUND or OUTBOUND
+                tuple, to store the 5-tuple
+  Return:       return 0 in case of success,
+                return -1 if it's not an IP packet
+*************************************************************/
+int flow_parse(struct sk_buff *skb, unsigned int direction,
+						struct flow_tuple *tuple)
+{
+	struct in6_addr saddr, daddr;
+	__be16 _ports[2], *ports = NULL;
+	int thoff = -1;
+	u8 protocol = 0;
+
+	memset(tuple, 0, sizeof(*tuple));
+
+	if (skb->protocol == htons(ETH_P_IP)) {
+		struct iphdr _iph, *iph;
+
+		iph = skb_header_pointer(skb, skb_network_offset(skb), sizeof(_iph), &_iph);
+		if (iph == NULL)
+			return -1;
+		ipv6_addr_set_v4mapped(iph->saddr, &saddr);
+		ipv6_addr_set_v4mapped(iph->daddr, &daddr);
+		protocol = iph->protocol;
+		tuple->family = AF_INET;
+		if (!(iph->frag_off & htons(IP_OFFSET)))
+			thoff = skb_network_offset(skb) + iph->ihl * 4;
+#if IS_ENABLED(CONFIG_IPV6)
+	} else if (skb->protocol == htons(ETH_P_IPV6)) {
+		struct ipv6hdr _ip6h, *ip6h;
+		__be16 frag_off = 0;
+
+		ip6h = skb_header_pointer(skb, skb_network_offset(skb), sizeof(_ip6h), &_ip6h);
+		if (ip6h == NULL)
+			return -1;
+		saddr = ip6h->saddr;
+		daddr = ip6h->daddr;
+		protocol = ip6h->nexthdr;
+		tuple->family = AF_INET6;
+		thoff = ipv6_skip_exthdr(skb, skb_network_offset(skb) + sizeof(_ip6h),
+						&protocol, &frag_off);
+		if (frag_off & htons(IP6_OFFSET))
+			thoff = -1;
+#endif
+	} else {
+		return -1;
+	}
+
+	switch (protocol) {
+	case IPPROTO_TCP:
+	case IPPROTO_UDP:
+	case IPPROTO_UDPLITE:
+	case IPPROTO_SCTP:
+	case IPPROTO_DCCP:
+		/* the first 4 bytes are the source and destination port */
+		if (thoff >= 0)
+			ports = skb_header_pointer(skb, thoff, sizeof(_ports), _ports);
+		break;
+	}
+
+	tuple->protocol = protocol;
+	if (direction == OUTBOUND) {
+		tuple->local_addr = saddr;
+		tuple->remote_addr = daddr;
+		if (ports != NULL) {
+			tuple->local_port = ports[0];
+			tuple->remote_port = ports[1];
+		}
+	} else {
+		tuple->local_addr = daddr;
+		tuple->remote_addr = saddr;
+		if (ports != NULL) {
+			tuple->local_port = ports[1];
+			tuple->remote_port = ports[0];
+		}
+	}
+
+	return 0;
+}
+
+static inline bool flow_idle(struct flow_entry *flow)
+{
+	return flow->active_time == 0 ||
+		time_after(jiffies, flow->active_time + FLOW_EXPIRE_TIME * HZ);
+}
+
+static inline u64 flow_bytes(struct flow_entry *flow)
+{
+	return flow->bytes[INBOUND] + flow->bytes[OUTBOUND];
+}
+
+/*************************************************************
+  Function:     flow_account
+  Description:  add a packet of a host to its flow in the table
+                of local CPU. Called from update_host_stat.
+  Input:        host, host entry of the packet
+                tuple, 5-tuple returned by flow_parse
+                direction, INBOUND or OUTBOUND
+                len, segs, wire length and number of segments
+*************************************************************/
+void flow_account(struct host_entry *host, const struct flow_tuple *tuple,
+						unsigned int direction,
+						unsigned int len, unsigned int segs)
+{
+	struct flow_entry *set = NULL, *flow = NULL, *victim = NULL;
+	u32 hash;
+	unsigned int i;
+
+	if (g_flow_sets == 0)
+		return;
+
+	hash = jhash2((const u32 *)tuple, sizeof(*tuple) / sizeof(u32),
+			g_flow_seed ^ (u32)host->mac_key ^ (u32)(host->mac_key >> 32));
+	set = __this_cpu_read(g_flow_table) + (hash & (g_flow_sets - 1)) * FLOW_WAYS;
+
+	for (i = 0; i < FLOW_WAYS; i++) {
+		if (set[i].active_time != 0 && set[i].mac_key == host->mac_key &&
+			memcmp(&set[i].tuple, tuple, sizeof(*tuple)) == 0) {
+			flow = &set[i];
+			goto account;
+		}
+
+		/* prefer an empty or idle slot, then the lightest flow */
+		if (victim == NULL || (!flow_idle(victim) &&
+			(flow_idle(&set[i]) || flow_bytes(&set[i]) < flow_bytes(victim))))
+			victim = &set[i];
+	}
+
+	flow = victim;
+	write_seqcount_begin(&flow->seq);
+	flow->mac_key = host->mac_key;
+	flow->tuple = *tuple;
+	flow->bytes[0] = flow->bytes[1] = 0;
+	flow->packets[0] = flow->packets[1] = 0;
+	flow->bytes[direction] = len;
+	flow->packets[direction] = segs;
+	flow->active_time = jiffies;
+	write_seqcount_end(&flow->seq);
+	return;
+
+account:
+	write_seqcount_begin(&flow->seq);
+	flow->bytes[direction] += len;
+	flow->packets[direction] += segs;
+	flow->active_time = jiffies;
+	write_seqcount_end(&flow->seq);
+}
+
+/*************************************************************
+  Function:     flow_read_next
+  Description:  copy the first flow at or after a position. The
+                positions run over the tables of all the CPUs.
+  Input:        pos, where to start
+                rec, to store the flow
+  Return:       position of the flow, -1 if there is no more
+*************************************************************/
+long flow_read_next(long pos, struct dt_flow_record *rec)
+{
+	unsigned int size = g_flow_sets * FLOW_WAYS;
+	struct flow_entry *table = NULL;
+	struct flow_entry flow;
+	unsigned int start, cpu;
+
+	for (; size != 0 && pos < (long)nr_cpu_ids * size; pos++) {
+		cpu = pos / size;
+		if (!cpu_possible(cpu)) {
+			pos = (long)(cpu + 1) * size - 1;
+			continue;
+		}
+		table = per_cpu(g_flow_table, cpu);
+
+		do {
+			start = read_seqcount_begin(&table[pos % size].seq);
+			flow = table[pos % size];
+		} while (read_seqcount_retry(&table[pos % size].seq, start));
+		if (flow.active_time == 0)
+			continue;
+
+		memset(rec, 0, sizeof(*rec));
+		key_to_mac(flow.mac_key, rec->mac_addr);
+		rec->protocol = flow.tuple.protocol;
+		rec->family = flow.tuple.family;
+		memcpy(rec->local_addr, &flow.tuple.local_addr, sizeof(rec->local_addr));
+		memcpy(rec->remote_addr, &flow.tuple.remote_addr, sizeof(rec->remote_addr));
+		rec->local_port = (__force __u16)flow.tuple.local_port;
+		rec->remote_port = (__force __u16)flow.tuple.remote_port;
+		rec->upload_bytes = flow.bytes[OUTBOUND];
+		rec->download_bytes = flow.bytes[INBOUND];
+		rec->upload_packets = flow.packets[OUTBOUND];
+		rec->download_packets = flow.packets[INBOUND];
+
+		return pos;
+	}
+
+	return -1;
+}
+
+/*************************************************************
+  Function:     flow_table_init
+  Description:  allocate the flow table of each CPU on its node
+  Return:       return 0 in case of success,
+                return -ENOMEM if out of memory
+*************************************************************/
+int flow_table_init(void)
+{
+	struct flow_entry *table = NULL;
+	size_t len;
+	unsigned int cpu, i;
+
+	if (flow_capacity == 0)
+		return 0;
+
+	g_flow_sets = roundup_pow_of_two(DIV_ROUND_UP(flow_capacity, FLOW_WAYS));
+	len = g_flow_sets * FLOW_WAYS * sizeof(struct flow_entry);
+	get_random_bytes(&g_flow_seed, sizeof(g_flow_seed));
+
+	for_each_possible_cpu(cpu) {
+		if (len > PAGE_SIZE)
+			table = vzalloc_node(len, cpu_to_node(cpu));
+		else
+			table = kzalloc_node(len, GFP_KERNEL, cpu_to_node(cpu));
+		if (table == NULL) {
+			flow_table_exit();
+			return -ENOMEM;
+		}
+
+		for (i = 0; i < g_flow_sets * FLOW_WAYS; i++)
+			seqcount_init(&table[i].seq);
+		per_cpu(g_flow_table, cpu) = table;
+	}
+
+	return 0;
+}
+
+/* free the flow tables, called once the hooks are unregistered */
+void flow_table_exit(void)
+{
+	struct flow_entry *table = NULL;
+	unsigned int cpu;
+
+	for_each_possible_cpu(cpu) {
+		table = per_cpu(g_flow_table, cpu);
+		if (table == NULL)
+			continue;
+
+		if (is_vmalloc_addr(table))
+			vfree(table);
+		else
+			kfree(table);
+		per_cpu(g_flow_table, cpu) = NULL;
+	}
+	g_flow_sets = 0;
+}
@@ -0,0 +1,66 @@
+/*********************************************************
+* FILE NAME		:	data_traffic_flow.h
+* VERSION		:	1.0
+* DESCRIPTION	:	Per-flow statistics under the host entries,
+*					keyed by MAC address and 5-tuple, so that
+*					the connections of a heavy host can be told
+*					apart.
+*
+* CREATE DATE	:	17/10/2026
+*********************************************************/
+#ifndef _DATA_TRAFFIC_FLOW_H
+#define _DATA_TRAFFIC_FLOW_H
+
+#include <linux/types.h>
+#include <linux/in6.h>
+#include <linux/seqlock.h>
+#include <linux/skbuff.h>
+#include "data_traffic_export.h"
+#include "data_traffic_host_entry.h"
+
+/* flows per CPU by default, module parameter */
+#define DEFAULT_FLOW_CAPACITY 256
+/* ways of a set, a new flow replaces one flow of its set */
+#define FLOW_WAYS 4
+/* a flow without traffic in this period of seconds is replaced first */
+#define FLOW_EXPIRE_TIME 60
+
+/**
+ * 5-tuple of a flow. The host side of the connection is the local address
+ * and port whichever the direction, IPv4 addresses are kept IPv4-mapped.
+ * Compared with memcmp, so it's zeroed before being filled.
+ */
+struct flow_tuple {
+	struct in6_addr local_addr;
+	struct in6_addr remote_addr;
+	__be16 local_port;
+	__be16 remote_port;
+	u8 protocol;
+	u8 family;
+};
+
+/**
+ * one flow, owned by one CPU, an empty slot has active_time 0.
+ * seq lets readers of other CPUs copy it consistently.
+ */
+struct flow_entry {
+	seqcount_t seq;
+	u64 mac_key;
+	struct flow_tuple tuple;
+	unsigned long active_time;
+	u64 bytes[2];
+	u64 packets[2];
+};
+
+extern unsigned int flow_capacity;
+
+extern int flow_table_init(void);
+extern void flow_table_exit(void);
+extern int flow_parse(struct sk_buff *skb, unsigned int direction,
+						struct flow_tuple *tuple);
+extern void flow_account(struct host_entry *host, const struct flow_tuple *tuple,
+						unsigned int direction,
+						unsigned int len, unsigned int segs);
+extern long flow_read_next(long pos, struct dt_flow_record *rec);
+
+#endif
@@ -10,124 +10,585 @@
 * CREATE DATE	:	13/10/2016
 *********************************************************/
 #include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/moduleparam.h>
+#include <linux/slab.h>
+#include <linux/log2.h>
+#include <linux/bug.h>
+#include <linux/cache.h>
+#include <linux/stddef.h>
 #include <linux/list.h>
 #include <linux/skbuff.h>
+#include <linux/tcp.h>
+#include <linux/udp.h>
+#include <linux/percpu.h>
+#include <linux/string.h>
+#include <linux/rcupdate.h>
+#include <linux/workqueue.h>
+#include <linux/topology.h>
+#include <linux/mm.h>
+#include <linux/atomic.h>
+#include <linux/netdevice.h>
+#include <net/ipv6.h>
+#include <net/net_namespace.h>
 #include "data_traffic_host_entry.h"
 #include "data_traffic_tbl_ops.h"
 #include "data_traffic_proc.h"
+#include "data_traffic_flow.h"
+#include "data_traffic_class.h"
+#include "data_traffic_port.h"
 
-/* host entry space apply, 64 totally */
-struct host_entry g_host_pool[MAX_HOST_NUM];
+/* max number of host entries */
+unsigned int host_capacity = DEFAULT_HOST_CAPACITY;
+module_param(host_capacity, uint, 0444);
+MODULE_PARM_DESC(host_capacity, "max number of recorded hosts");
+
+/* slab cache of host entries */
+static struct kmem_cache *g_host_cache;
 
 /* hash table defination */
-struct hlist_head g_hash_table[MAX_HOST_NUM];
+struct host_hash_table __rcu *g_hash_table;
+
+/* number of hosts in hash table */
+unsigned int g_host_count;
+
+/* entries allocated from the slab cache, never more than host_capacity */
+static atomic_t g_host_allocated;
 
-/* free table head defination */
-static struct list_head free_table_entity;
-struct list_head *g_free_table = &free_table_entity;
+/**
+ * Per-CPU magazine of free host entries, all on the NUMA node of its CPU,
+ * so a new host never touches a shared free list. Its lock is taken with
+ * BH disabled, only contended when another CPU ran out of entries and
+ * takes one, see host_magazine_steal. The refill work runs on this CPU in
+ * process context, since alloc_percpu() may sleep.
+ */
+struct host_magazine {
+	spinlock_t lock;
+	unsigned int count;
+	int node;
+	struct host_entry *entry[HOST_MAGAZINE_SIZE];
+	struct work_struct refill;
+};
+static DEFINE_PER_CPU(struct host_magazine, g_host_magazine);
+
+/**
+ * Entries kept in a magazine and the level it's refilled at. All the
+ * magazines together hold at most half of host_capacity, and a CPU
+ * takes the spare entries of the others before a host is evicted.
+ */
+static unsigned int g_magazine_size __read_mostly;
+static unsigned int g_magazine_low __read_mostly;
 
 /* recently used table head defination */
 static struct list_head lru_table_entity;
 struct list_head *g_lru_table = &lru_table_entity;
 
-void host_entry_data_init(void)
+/* eviction counters */
+unsigned long g_evict_count;
+unsigned long g_evict_active_count;
+
+/**********************************************************
+  Function:     alloc_host_entry
+  Description:  allocate a host entry from the slab cache,
+                with its per-CPU counters. It may sleep.
+  Input:        node, NUMA node to allocate the entry on
+  Return:       the host entry, NULL if out of memory or
+                host_capacity entries are allocated
+**********************************************************/
+struct host_entry *alloc_host_entry(int node)
 {
-	int i;
+	struct host_entry *host = NULL;
 
-	/* init the three heads in each host entry */
-	for (i = 0; i < MAX_HOST_NUM; i++) {
-		INIT_LIST_HEAD(&g_host_pool[i].free_tbl_node);
-		INIT_LIST_HEAD(&g_host_pool[i].lru_tbl_node);
-		INIT_HLIST_NODE(&g_host_pool[i].hash_tbl_node);
+	if (atomic_inc_return(&g_host_allocated) > host_capacity)
+		goto fail;
+
+	host = kmem_cache_alloc_node(g_host_cache, GFP_KERNEL | __GFP_ZERO, node);
+	if (host == NULL)
+		goto fail;
+
+	host->counter = alloc_percpu(struct host_counter);
+	if (host->counter == NULL) {
+		kmem_cache_free(g_host_cache, host);
+		goto fail;
 	}
 
-	/* init hash table */
-	for (i = 0; i < MAX_HOST_NUM; i++)
-		INIT_HLIST_HEAD(g_hash_table + i);
+	INIT_LIST_HEAD(&host->lru_tbl_node);
+	INIT_LIST_HEAD(&host->expiry_node);
+	spin_lock_init(&host->rate_lock);
+	spin_lock_init(&host->addr_lock);
+	INIT_HLIST_NODE(&host->hash_tbl_node[0]);
+	INIT_HLIST_NODE(&host->hash_tbl_node[1]);
 
-	/* init lru table */
-	INIT_LIST_HEAD(g_lru_table);
+	return host;
 
-	/* init free table, add all the nodes to free table */
-	INIT_LIST_HEAD(g_free_table);
-	for (i = 0; i < MAX_HOST_NUM; i++)
-		list_add_tail(&g_host_pool[i].free_tbl_node, g_free_table);
+fail:
+	atomic_dec(&g_host_allocated);
+	return NULL;
 }
 
-/*********************************************************************
-  Function:     add_host_entry
-  Description:  add a new host entry, if free table is empty, free one
-                entry from lru table.
-  Input:        mac_addr:   MAC address of the host
-                ip_addr:    IP address of the host
-                access_device_name: access device of the host(eth or ath)
+/* give a host entry back to the system, it may be called in softirq */
+static void free_host_entry(struct host_entry *host)
+{
+	free_percpu(host->counter);
+	kmem_cache_free(g_host_cache, host);
+	atomic_dec(&g_host_allocated);
+}
 
-  Return:       return 1 if parameter error, NULL input
-                return 0 if add a new host entry successfully
-                return -1 if this host entry has already been recorded
-********************************************************************/
-int add_host_entry(unsigned char *mac_addr, unsigned int ip_addr, char *access_device_name)
+/*************************************************************
+  Function:     host_magazine_refill
+  Description:  work item, fill the magazine of this CPU with
+                entries allocated on its node
+*************************************************************/
+static void host_magazine_refill(struct work_struct *work)
 {
-	if (mac_addr == NULL) {
-		printk(KERN_ERR "parameter error\n");
-		return -1;
+	struct host_magazine *mag = container_of(work, struct host_magazine, refill);
+	struct host_entry *host = NULL;
+
+	while (ACCESS_ONCE(mag->count) < g_magazine_size) {
+		host = alloc_host_entry(mag->node);
+		if (host == NULL)
+			break;
+
+		spin_lock_bh(&mag->lock);
+		if (mag->count < g_magazine_size) {
+			mag->entry[mag->count++] = host;
+			host = NULL;
+		}
+		spin_unlock_bh(&mag->lock);
+
+		if (host != NULL) {
+			free_host_entry(host);
+			break;
+		}
 	}
+}
 
-	/* find if the MAC address has been already recorded */
-	if (hlist_find_host_by_mac(mac_addr) == NULL) {
-		/* didn't find the mac address in hash table, need to record */
-		add_new_host_entry(mac_addr, ip_addr, access_device_name);
+/*************************************************************
+  Function:     host_magazine_steal
+  Description:  take a free entry from the magazine of another
+                CPU, those on the same node first. Offline CPUs
+                are tried too, they keep their entries. Called
+                with BH disabled.
+  Input:        self, CPU whose magazine is empty
+                node, NUMA node of this CPU
+  Return:       the free entry, NULL if all the magazines are
+                empty
+*************************************************************/
+static struct host_entry *host_magazine_steal(int self, int node)
+{
+	struct host_magazine *mag = NULL;
+	struct host_entry *host = NULL;
+	int same_node, cpu;
 
-		return 0;
-	} else {
-		/* This MAC address has already been recorded */
-		return 1;
+	for (same_node = 1; same_node >= 0; same_node--) {
+		for_each_possible_cpu(cpu) {
+			mag = per_cpu_ptr(&g_host_magazine, cpu);
+			if (cpu == self || (mag->node == node) != same_node ||
+					ACCESS_ONCE(mag->count) == 0)
+				continue;
+
+			spin_lock(&mag->lock);
+			if (mag->count > 0)
+				host = mag->entry[--mag->count];
+			spin_unlock(&mag->lock);
+			if (host != NULL)
+				return host;
+		}
+	}
+
+	return NULL;
+}
+
+/*************************************************************
+  Function:     host_entry_get
+  Description:  take a free entry from the magazine of this
+                CPU, the refill work is queued once it runs
+                low. An empty magazine takes one from another
+                CPU, since the refill can't run in softirq.
+                It never sleeps.
+  Return:       the free entry, NULL if all the magazines are
+                empty
+*************************************************************/
+struct host_entry *host_entry_get(void)
+{
+	struct host_magazine *mag = NULL;
+	struct host_entry *host = NULL;
+	int cpu;
+
+	local_bh_disable();
+	cpu = smp_processor_id();
+	mag = per_cpu_ptr(&g_host_magazine, cpu);
+
+	spin_lock(&mag->lock);
+	if (mag->count > 0)
+		host = mag->entry[--mag->count];
+	if (mag->count < g_magazine_low)
+		schedule_work_on(cpu, &mag->refill);
+	spin_unlock(&mag->lock);
+
+	if (host == NULL)
+		host = host_magazine_steal(cpu, mag->node);
+	local_bh_enable();
+
+	return host;
+}
+
+/*************************************************************
+  Function:     host_entry_put
+  Description:  put a free entry back in the magazine of this
+                CPU. If the magazine is full or the entry is
+                on another node, it's freed, so the memory of
+                expired hosts goes back to the system.
+  Input:        host, entry no reader can see any more
+*************************************************************/
+void host_entry_put(struct host_entry *host)
+{
+	struct host_magazine *mag = NULL;
+
+	local_bh_disable();
+	mag = this_cpu_ptr(&g_host_magazine);
+	spin_lock(&mag->lock);
+	if (mag->count < g_magazine_size &&
+			page_to_nid(virt_to_page(host)) == mag->node) {
+		mag->entry[mag->count++] = host;
+		host = NULL;
 	}
+	spin_unlock(&mag->lock);
+	local_bh_enable();
+
+	if (host != NULL)
+		free_host_entry(host);
+}
+
+/**
+ * true if no more entry can be allocated. With all the magazines empty,
+ * see host_entry_get, a host must be evicted.
+ */
+bool host_entry_pool_full(void)
+{
+	return atomic_read(&g_host_allocated) >= host_capacity;
+}
+
+/* number of entries allocated, in use or in the magazines */
+unsigned int host_entry_allocated(void)
+{
+	return atomic_read(&g_host_allocated);
+}
+
+/*****************************************************************
+  Function:     host_entry_data_init
+  Description:  init the hash table, lru table and the per-CPU
+                magazines, the magazine of each online CPU
+                is filled with entries on its node. Other
+                entries are allocated as hosts show up.
+  Return:       return 0 in case of success,
+                return -ENOMEM if out of memory
+*****************************************************************/
+int host_entry_data_init(void)
+{
+	struct host_magazine *mag = NULL;
+	int cpu;
+
+	BUILD_BUG_ON(HOST_CLASS_NUM != CLASS_NUM);
+
+	/* layout check, the packet path must only touch the hot part */
+	BUILD_BUG_ON(offsetof(struct host_entry, hash_tbl_node) != 0);
+	BUILD_BUG_ON(offsetof(struct host_entry, policed) + 1 > HOST_HOT_SIZE);
+	BUILD_BUG_ON(offsetof(struct host_entry, lru_tbl_node) % SMP_CACHE_BYTES != 0);
+	BUILD_BUG_ON(offsetof(struct host_entry, lru_tbl_node) >
+			ALIGN(offsetof(struct host_entry, policed) + 1, SMP_CACHE_BYTES));
+
+	/* init lru table, magazines and expiry wheel */
+	INIT_LIST_HEAD(g_lru_table);
+	g_host_count = 0;
+	atomic_set(&g_host_allocated, 0);
+	expiry_wheel_init();
+	for_each_possible_cpu(cpu) {
+		mag = per_cpu_ptr(&g_host_magazine, cpu);
+		spin_lock_init(&mag->lock);
+		mag->count = 0;
+		mag->node = cpu_to_node(cpu);
+		INIT_WORK(&mag->refill, host_magazine_refill);
+	}
+
+	if (host_capacity == 0)
+		host_capacity = DEFAULT_HOST_CAPACITY;
+	g_magazine_size = clamp_t(unsigned int, host_capacity / (2 * num_possible_cpus()),
+					1, HOST_MAGAZINE_SIZE);
+	g_magazine_low = DIV_ROUND_UP(g_magazine_size, 4);
+
+	g_host_cache = kmem_cache_create("data_traffic_host", sizeof(struct host_entry),
+						0, SLAB_HWCACHE_ALIGN, NULL);
+	if (g_host_cache == NULL) {
+		printk(KERN_ERR "Create host entry cache failed.\n");
+		return -ENOMEM;
+	}
+
+	/* init hash table, it's grown along with the number of hosts */
+	if (init_hash_table() < 0) {
+		printk(KERN_ERR "Alloc hash table failed.\n");
+		goto fail;
+	}
+
+	/* no hook is registered yet, nobody else uses the magazines */
+	for_each_online_cpu(cpu) {
+		mag = per_cpu_ptr(&g_host_magazine, cpu);
+		while (mag->count < g_magazine_size) {
+			mag->entry[mag->count] = alloc_host_entry(mag->node);
+			if (mag->entry[mag->count] == NULL)
+				break;
+			mag->count++;
+		}
+	}
+
+	return 0;
+
+fail:
+	host_entry_data_exit();
+	return -ENOMEM;
+}
+
+/*********************************************
+  Function:     host_entry_data_exit
+  Description:  free all the host entries and
+                the hash table, after all the
+                pending RCU callbacks and refill
+                works are done
+*********************************************/
+void host_entry_data_exit(void)
+{
+	struct host_magazine *mag = NULL;
+	struct host_entry *host = NULL;
+	struct host_entry *tmp = NULL;
+	int cpu;
+
+	destroy_hash_table();
+	rcu_barrier();
+	for_each_possible_cpu(cpu)
+		cancel_work_sync(&per_cpu_ptr(&g_host_magazine, cpu)->refill);
+
+	list_for_each_entry_safe(host, tmp, g_lru_table, lru_tbl_node) {
+		list_del(&host->lru_tbl_node);
+		free_host_entry(host);
+	}
+	for_each_possible_cpu(cpu) {
+		mag = per_cpu_ptr(&g_host_magazine, cpu);
+		while (mag->count > 0)
+			free_host_entry(mag->entry[--mag->count]);
+	}
+
+	if (g_host_cache != NULL) {
+		kmem_cache_destroy(g_host_cache);
+		g_host_cache = NULL;
+	}
+}
+
+/****************************************************************
+  Function:     skb_wire_len
+  Description:  get the bytes and segments an skb stands for on
+                the wire. A GSO/GRO skb carries many segments,
+                each of them has its own L2, IP and TCP header.
+  Input:        skb, received data, data points to IP header
+                segs, to store the number of segments
+  Return:       bytes on the wire, ethernet header included
+****************************************************************/
+unsigned int skb_wire_len(const struct sk_buff *skb, unsigned int *segs)
+{
+	const struct skb_shared_info *shinfo = skb_shinfo(skb);
+	unsigned int hdr_len;
+
+	*segs = 1;
+	if (!skb_is_gso(skb))
+		return skb->len + ETH_HLEN;
+
+	/* headers repeated in every segment, from the IP header on */
+	if (shinfo->gso_type & (SKB_GSO_TCPV4 | SKB_GSO_TCPV6))
+		hdr_len = skb_transport_offset(skb) + tcp_hdrlen(skb);
+	else if (shinfo->gso_type & SKB_GSO_UDP)
+		hdr_len = skb_transport_offset(skb) + sizeof(struct udphdr);
+	else
+		hdr_len = skb_network_header_len(skb);
+
+	/* GRO of this kernel doesn't always fill gso_segs */
+	*segs = shinfo->gso_segs;
+	if (*segs == 0 && skb->len > hdr_len)
+		*segs = DIV_ROUND_UP(skb->len - hdr_len, shinfo->gso_size);
+	if (*segs <= 1) {
+		*segs = 1;
+		return skb->len + ETH_HLEN;
+	}
+
+	return skb->len + (*segs - 1) * hdr_len + *segs * ETH_HLEN;
 }
 
 /**************************************************************
   Function:     update_host_stat
-  Description:  update information and status of a host
-  Input:        mac_addr:   MAC address of the host
-                ip_addr:    IP address of the host
+  Description:  update status of a host
+  Input:        host:       host entry returned by
+                            lookup_or_add_host_entry
                 skb:        received data, sk_buff
                 flag:       inbound or outbound
-                access_device_name: through which net device to
-                                    access this host
+                ifindex:    bridge port through which this host
+                            is accessed
+                vid:        VLAN of the packet, 0 if untagged
+                The aggregate of the port and VLAN is counted in
+                the same pass. Called under rcu_read_lock().
 ***************************************************************/
-void update_host_stat(unsigned char *mac_addr, unsigned int ip_addr,
-						struct sk_buff *skb, int flag, char *access_device_name)
+void update_host_stat(struct host_entry *host, struct sk_buff *skb,
+						int flag, int ifindex, u16 vid)
 {
-	struct iphdr *ip_header = ip_hdr(skb);
-	struct hlist_node *hash_node = hlist_find_host_by_mac(mac_addr);
-	struct host_entry *host = NULL;
+	struct host_counter *counter = NULL;
+	struct flow_tuple tuple;
+	unsigned int segs = 0;
+	unsigned int len = skb_wire_len(skb, &segs);
+	unsigned int class = CLASS_OTHER;
+	int parsed = 0;
 
-	if (hash_node == NULL) {
-		/* If this MAC address has not been recorded in hash table, return */
-		goto exit;
-	}
+	/* only the flow tier and the classifier need the L4 header */
+	if (flow_capacity != 0 || rcu_access_pointer(g_class_table) != NULL)
+		parsed = flow_parse(skb, flag, &tuple) == 0;
+	if (parsed)
+		class = class_lookup(&tuple);
+
+	/* a host may move to another port, only written when it does */
+	if (host->info.ifindex != ifindex)
+		host->info.ifindex = ifindex;
+
+	/* give this host a second chance against CLOCK eviction */
+	if (!ACCESS_ONCE(host->referenced))
+		host->referenced = 1;
 
-	host = hlist_entry(hash_node, struct host_entry, hash_tbl_node);
+	/* Only the shard of the local CPU is written on the packet path */
+	counter = this_cpu_ptr(host->counter);
+	u64_stats_update_begin(&counter->syncp);
+	if (flag == INBOUND) {
+		/* Download, update download information */
+		counter->download_bytes += len;
+		counter->download_packets += segs;
+	} else {
+		counter->upload_bytes += len;
+		counter->upload_packets += segs;
+	}
+	counter->class_bytes[flag][class] += len;
+	u64_stats_update_end(&counter->syncp);
 	/* Update the last active time of this host */
-	host->stat.active_time = jiffies;
+	counter->active_time = jiffies;
+
+	port_account(ifindex, vid, flag, len, segs);
+	if (parsed)
+		flow_account(host, &tuple, flag, len, segs);
+}
+/**************************************************************
+  Function:     host_class_read
+  Description:  fold the bytes of each traffic class of a host
+  Input:        host, which host entry to read
+                class_bytes, to store the bytes of each class,
+                             indexed by direction and class
+***************************************************************/
+void host_class_read(struct host_entry *host, u64 class_bytes[2][HOST_CLASS_NUM])
+{
+	struct host_counter *counter = NULL;
+	u64 bytes[2][HOST_CLASS_NUM];
+	unsigned int start, i;
+	int cpu;
+
+	memset(class_bytes, 0, sizeof(bytes));
+
+	for_each_possible_cpu(cpu) {
+		counter = per_cpu_ptr(host->counter, cpu);
+		do {
+			start = u64_stats_fetch_begin_bh(&counter->syncp);
+			memcpy(bytes, counter->class_bytes, sizeof(bytes));
+		} while (u64_stats_fetch_retry_bh(&counter->syncp, start));
+
+		for (i = 0; i < HOST_CLASS_NUM; i++) {
+			class_bytes[INBOUND][i] += bytes[INBOUND][i];
+			class_bytes[OUTBOUND][i] += bytes[OUTBOUND][i];
+		}
+	}
+}
+
+/**************************************************************
+  Function:     host_update_ip
+  Description:  record the IPv4 address of a host
+  Input:        host, host entry of the packet
+                ip_addr, IPv4 address of the host
+***************************************************************/
+void host_update_ip(struct host_entry *host, unsigned int ip_addr)
+{
 	/* If IP of this host has been changed, update it */
 	if (host->info.ip_addr != ip_addr)
 		host->info.ip_addr = ip_addr;
-	if (strncmp(host->info.access_device_name, access_device_name, strlen(access_device_name)) != 0)
-		memcpy(host->info.access_device_name, access_device_name, strlen(access_device_name));
+}
 
-	if (flag == INBOUND) {
-		/* Download, update download information */
-		host->stat.download_total += ip_header->tot_len + sizeof(struct ethhdr);
-		host->stat.download_speed_current += ip_header->tot_len + sizeof(struct ethhdr);
-	} else {
-		host->stat.upload_total += ip_header->tot_len + sizeof(struct ethhdr);
-		host->stat.upload_speed_current += ip_header->tot_len + sizeof(struct ethhdr);
+/* lock-free compare against the whole ring, a torn slot only misses */
+static inline bool host_has_ip6(struct host_entry *host, const struct in6_addr *ip6_addr)
+{
+	unsigned int i;
+
+	for (i = 0; i < HOST_IP6_NUM; i++) {
+		if (ipv6_addr_equal(&host->ip6_addr[i], ip6_addr))
+			return true;
+	}
+
+	return false;
+}
+
+/**************************************************************
+  Function:     host_update_ip6
+  Description:  record an IPv6 address of a host. The packet
+                path compares the address with each slot of the
+                ring without lock, so a host using temporary
+                and stable addresses at once only reads it. The
+                lock is taken and the ring written only when
+                the address is in no slot.
+  Input:        host, host entry of the packet
+                ip6_addr, IPv6 address of the host
+***************************************************************/
+void host_update_ip6(struct host_entry *host, const struct in6_addr *ip6_addr)
+{
+	if (likely(host_has_ip6(host, ip6_addr)))
+		return;
+
+	spin_lock_bh(&host->addr_lock);
+	/* another CPU may have recorded it in the meantime */
+	if (!host_has_ip6(host, ip6_addr)) {
+		/* a new address replaces the oldest one */
+		host->ip6_addr[host->ip6_count % HOST_IP6_NUM] = *ip6_addr;
+		host->ip6_count++;
 	}
+	spin_unlock_bh(&host->addr_lock);
+}
+
+/* forget the IPv6 addresses of a host entry being reused */
+void host_ip6_reset(struct host_entry *host)
+{
+	spin_lock_bh(&host->addr_lock);
+	host->ip6_count = 0;
+	/* unused slots must not match the addresses of the last host */
+	memset(host->ip6_addr, 0, sizeof(host->ip6_addr));
+	spin_unlock_bh(&host->addr_lock);
+}
+
+/**************************************************************
+  Function:     host_ip6_read
+  Description:  copy the IPv6 addresses of a host
+  Input:        host, which host entry to read
+                ip6_addr, array of HOST_IP6_NUM addresses
+  Return:       number of addresses copied
+***************************************************************/
+unsigned int host_ip6_read(struct host_entry *host, struct in6_addr *ip6_addr)
+{
+	unsigned int num;
 
-exit:
-	return;
+	spin_lock_bh(&host->addr_lock);
+	num = min_t(unsigned int, host->ip6_count, HOST_IP6_NUM);
+	memcpy(ip6_addr, host->ip6_addr, num * sizeof(*ip6_addr));
+	spin_unlock_bh(&host->addr_lock);
+
+	return num;
 }
+
 /********************************************
   Function:     delete_host_entry
   Description:  delete a host entry
@@ -137,3 +598,222 @@ void delete_host_entry(struct host_entry *host)
 {
 	remove_host_entry(host);
 }
+
+/**********************************************************
+  Function:     host_counter_reset
+  Description:  zero the per-CPU counters of a host entry,
+                the last active time is set to now on the
+                local CPU
+  Input:        host, which host entry to reset
+**********************************************************/
+void host_counter_reset(struct host_entry *host)
+{
+	struct host_counter *counter = NULL;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		counter = per_cpu_ptr(host->counter, cpu);
+		counter->upload_bytes = 0;
+		counter->download_bytes = 0;
+		counter->upload_packets = 0;
+		counter->download_packets = 0;
+		memset(counter->class_bytes, 0, sizeof(counter->class_bytes));
+		counter->active_time = 0;
+	}
+
+	this_cpu_ptr(host->counter)->active_time = jiffies;
+}
+
+/**************************************************************
+  Function:     host_counter_add
+  Description:  add the totals of a dump record to the shard of
+                local CPU. Called with preemption disabled.
+  Input:        host, which host entry to restore
+                rec, record of this host in the dump
+***************************************************************/
+void host_counter_add(struct host_entry *host, const struct dt_host_record *rec)
+{
+	struct host_counter *counter = this_cpu_ptr(host->counter);
+
+	u64_stats_update_begin(&counter->syncp);
+	counter->upload_bytes += rec->upload_total;
+	counter->download_bytes += rec->download_total;
+	counter->upload_packets += rec->upload_packets;
+	counter->download_packets += rec->download_packets;
+	u64_stats_update_end(&counter->syncp);
+}
+
+/*************************************************************
+  Function:     host_stat_fold
+  Description:  sum the per-CPU counters of a host entry into
+                stat, the last active time is the latest one
+                of all the CPUs. Speed fields are left as zero,
+                see host_stat_read.
+  Input:        host, which host entry to fold
+                stat, where to store the result
+*************************************************************/
+void host_stat_fold(struct host_entry *host, struct host_stat *stat)
+{
+	struct host_counter *counter = NULL;
+	u64 upload_bytes, download_bytes, upload_packets, download_packets;
+	unsigned long active_time;
+	unsigned int start;
+	int cpu;
+
+	memset(stat, 0, sizeof(*stat));
+
+	for_each_possible_cpu(cpu) {
+		counter = per_cpu_ptr(host->counter, cpu);
+		do {
+			start = u64_stats_fetch_begin_bh(&counter->syncp);
+			upload_bytes = counter->upload_bytes;
+			download_bytes = counter->download_bytes;
+			upload_packets = counter->upload_packets;
+			download_packets = counter->download_packets;
+		} while (u64_stats_fetch_retry_bh(&counter->syncp, start));
+
+		stat->upload_total += upload_bytes;
+		stat->download_total += download_bytes;
+		stat->upload_packets += upload_packets;
+		stat->download_packets += download_packets;
+
+		active_time = ACCESS_ONCE(counter->active_time);
+		if (active_time != 0 &&
+			(stat->active_time == 0 || time_after(active_time, stat->active_time)))
+			stat->active_time = active_time;
+	}
+}
+
+/*********************************************************
+  Function:     host_rate_reset
+  Description:  restart the rate estimator of a new host
+                entry from its current totals
+  Input:        host, which host entry to reset
+*********************************************************/
+void host_rate_reset(struct host_entry *host)
+{
+	struct host_stat stat;
+	u64 bytes[RATE_DIR_NUM];
+	u64 packets[RATE_DIR_NUM];
+
+	host_stat_fold(host, &stat);
+	bytes[INBOUND] = stat.download_total;
+	bytes[OUTBOUND] = stat.upload_total;
+	packets[INBOUND] = stat.download_packets;
+	packets[OUTBOUND] = stat.upload_packets;
+
+	spin_lock_bh(&host->rate_lock);
+	rate_estimator_reset(&host->rate, bytes, packets);
+	spin_unlock_bh(&host->rate_lock);
+}
+
+/****************************************************************
+  Function:     host_rate_update
+  Description:  feed the rate estimator of a host with its folded
+                totals. Called by the timer every second, so that
+                the averages move whether they are read or not.
+  Input:        host, which host entry
+****************************************************************/
+void host_rate_update(struct host_entry *host)
+{
+	struct host_stat stat;
+	u64 bytes[RATE_DIR_NUM];
+	u64 packets[RATE_DIR_NUM];
+
+	host_stat_fold(host, &stat);
+	bytes[INBOUND] = stat.download_total;
+	bytes[OUTBOUND] = stat.upload_total;
+	packets[INBOUND] = stat.download_packets;
+	packets[OUTBOUND] = stat.upload_packets;
+
+	spin_lock_bh(&host->rate_lock);
+	rate_estimator_update(&host->rate, bytes, packets);
+	spin_unlock_bh(&host->rate_lock);
+}
+
+/****************************************************************
+  Function:     host_stat_read
+  Description:  fold the per-CPU counters of a host and get its
+                speed, the 1s rate of the estimator advanced by
+                the timer
+  Input:        host, which host entry to read
+                stat, where to store the result
+****************************************************************/
+void host_stat_read(struct host_entry *host, struct host_stat *stat)
+{
+	struct rate_report report;
+
+	host_stat_fold(host, stat);
+	host_rate_read(host, &report);
+
+	stat->upload_speed = report.bytes[OUTBOUND][0];
+	stat->download_speed = report.bytes[INBOUND][0];
+}
+
+/****************************************************************
+  Function:     host_rate_read
+  Description:  get the rates of a host over all the windows, as
+                of the last timer tick
+  Input:        host, which host entry to read
+                report, where to store the rates
+****************************************************************/
+void host_rate_read(struct host_entry *host, struct rate_report *report)
+{
+	spin_lock_bh(&host->rate_lock);
+	rate_estimator_report(&host->rate, report);
+	spin_unlock_bh(&host->rate_lock);
+}
+
+/*************************************************************
+  Function:     host_active_time
+  Description:  get the last active time of a host, the latest
+                one of all the CPUs
+  Input:        host, which host entry
+  Return:       last active time in jiffies
+*************************************************************/
+unsigned long host_active_time(struct host_entry *host)
+{
+	unsigned long latest = 0;
+	unsigned long active_time;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		active_time = ACCESS_ONCE(per_cpu_ptr(host->counter, cpu)->active_time);
+		if (active_time != 0 && (latest == 0 || time_after(active_time, latest)))
+			latest = active_time;
+	}
+
+	return latest;
+}
+
+/*************************************************************
+  Function:     host_entry_to_record
+  Description:  fill the fixed layout record of a host, shared
+                with userspace. Called under rcu_read_lock().
+  Input:        host, which host entry to export
+                rec, where to store the record
+*************************************************************/
+void host_entry_to_record(struct host_entry *host, struct dt_host_record *rec)
+{
+	struct net_device *dev = NULL;
+	struct host_stat stat;
+
+	host_stat_read(host, &stat);
+
+	memset(rec, 0, sizeof(*rec));
+	memcpy(rec->mac_addr, host->mac_addr, ETH_ALEN);
+	BUILD_BUG_ON(DT_DEVICE_NAME_LEN < IFNAMSIZ);
+
+	/* the name of the port is only looked up when it's exported */
+	dev = dev_get_by_index_rcu(&init_net, ACCESS_ONCE(host->info.ifindex));
+	if (dev != NULL)
+		memcpy(rec->access_device_name, dev->name,
+			strnlen(dev->name, DT_DEVICE_NAME_LEN - 1));
+	rec->ip_addr = host->info.ip_addr;
+	rec->upload_speed = stat.upload_speed;
+	rec->download_speed = stat.download_speed;
+	rec->upload_total = stat.upload_total;
+	rec->download_total = stat.download_total;
+	rec->upload_packets = stat.upload_packets;
+	rec->download_packets = stat.download_packets;
+}
@@ -16,70 +16,194 @@
 #include <linux/timer.h>
 #include <linux/if_ether.h>
 #include <linux/ip.h>
-
-#define MAX_HOST_NUM 8
+#include <linux/in6.h>
+#include <linux/percpu.h>
+#include <linux/bitops.h>
+#include <linux/rcupdate.h>
+#include <linux/spinlock.h>
+#include <linux/u64_stats_sync.h>
+#include <asm/unaligned.h>
+#include "data_traffic_export.h"
+#include "data_traffic_rate.h"
+#include "data_traffic_police.h"
+
+#define DEFAULT_HOST_CAPACITY 256
+#define HASH_TABLE_MIN_SIZE 16
+#define HASH_HISTOGRAM_SIZE 8
+#define HOST_HOT_SIZE 64
 #define HOST_EXPIRE_TIME 120
+/* a host evicted with traffic in this period of seconds is counted as active */
+#define HOST_ACTIVE_TIME 10
+/* IPv6 addresses recorded per host, privacy addresses rotate out the oldest */
+#define HOST_IP6_NUM 4
+
+/* max number of free entries kept at hand by a CPU */
+#define HOST_MAGAZINE_SIZE 16
+/* traffic classes counted per host, same as CLASS_NUM */
+#define HOST_CLASS_NUM 8
+/* neighbour cache slots a host can be cached in, same as NEIGH_CACHE_SIZE */
+#define HOST_NEIGH_SLOTS 64
 #define LAN_DEVICE_NAME "br-lan"
 #define LAN_DEVICE_DISPLAY_NAME "eth1"
 #define WAN_DEVICE_NAME "eth0"
 #define WIRELESS_DEVICE_NAME "ath"
-#define DEVICE_NAME_LEN 5
 
 #define INBOUND 0
 #define OUTBOUND 1
 
-/* record the neighbour's IP and MAC address */
+/* record the neighbour's IP address and ifindex of its bridge port, the MAC is the key */
 struct host_info {
 	unsigned int ip_addr;
-	unsigned char mac_addr[ETH_ALEN];
-	char access_device_name[DEVICE_NAME_LEN];
+	int ifindex;
+};
+
+/**
+ * per-CPU shard of the neighbour's data statistics, only written by
+ * the hook running on the owning CPU, folded by the timer and readers
+ */
+struct host_counter {
+	u64 upload_bytes;
+	u64 download_bytes;
+	u64 upload_packets;
+	u64 download_packets;
+	/* bytes of each traffic class, see data_traffic_class.h */
+	u64 class_bytes[2][HOST_CLASS_NUM];
+	unsigned long active_time;
+	struct u64_stats_sync syncp;
 };
 
-/* record the neighbour's data statistics */
+/**
+ * record the neighbour's data statistics, folded from the per-CPU shards,
+ * speed is the 1s rate of the estimator, advanced by the timer
+ */
 struct host_stat {
 	unsigned int upload_speed;
 	unsigned int download_speed;
-	unsigned int upload_speed_current;
-	unsigned int download_speed_current;
 	unsigned long long upload_total;
 	unsigned long long download_total;
-	unsigned int active_time;
+	unsigned long long upload_packets;
+	unsigned long long download_packets;
+	unsigned long active_time;
 };
 
-/* record each neighbour as a host entry */
+/**
+ * record each neighbour as a host entry, hash table and lru table are
+ * RCU protected. A free entry sits in the magazine of a CPU, see
+ * host_entry_get.
+ *
+ * The hot part is everything the packet path reads, it fits in the first
+ * HOST_HOT_SIZE bytes and is not written per packet. The cold part starts
+ * on its own cache line and is only used by table writers, timer and proc.
+ */
 struct host_entry {
-	struct list_head free_tbl_node;
-	struct list_head lru_tbl_node;
-	struct hlist_node hash_tbl_node;
+	/* hot part */
+	/* one node per hash table generation, see struct host_hash_table */
+	struct hlist_node hash_tbl_node[2];
+	/* MAC address as a 48 bits integer, see mac_to_key */
+	u64 mac_key;
+	struct host_counter __percpu *counter;
 	struct host_info info;
-	struct host_stat stat;
+	/* CLOCK referenced bit, only written when it's clear */
+	unsigned char referenced;
+	/* set if the MAC of this host has a policer rule, see police_apply */
+	unsigned char policed;
+
+	/* cold part */
+	struct list_head lru_tbl_node ____cacheline_aligned_in_smp;
+	struct rcu_head rcu;
+	unsigned int linked;
+	unsigned char mac_addr[ETH_ALEN];
+	/* expiry wheel slot, see expire_host_entries */
+	struct list_head expiry_node;
+	unsigned int expires;
+	spinlock_t rate_lock;
+	struct rate_estimator rate;
+	/* neighbour cache slots this host was cached in, see neigh_cache_update */
+	DECLARE_BITMAP(neigh_slots, HOST_NEIGH_SLOTS);
+	/**
+	 * IPv6 addresses, ring of the last HOST_IP6_NUM ones. The packet path
+	 * reads it without lock, it has its own cache line so that it's only
+	 * dirtied when a new address is recorded.
+	 */
+	struct in6_addr ip6_addr[HOST_IP6_NUM] ____cacheline_aligned_in_smp;
+	spinlock_t addr_lock;
+	unsigned int ip6_count;
+};
+
+/**
+ * hash table, grown online. The new table links the entries through the
+ * other hash_tbl_node, so readers of the old table are never disturbed.
+ */
+struct host_hash_table {
+	unsigned int size;
+	unsigned int node;
+	struct hlist_head buckets[0];
 };
 
-/* host entry space apply, 64 totally */
-extern struct host_entry g_host_pool[];
+/* pack a MAC address into one integer, compared with a single instruction */
+static inline u64 mac_to_key(const unsigned char *mac_addr)
+{
+	return ((u64)get_unaligned((const u16 *)mac_addr) << 32) |
+			get_unaligned((const u32 *)(mac_addr + 2));
+}
+
+/* unpack the MAC address of mac_to_key */
+static inline void key_to_mac(u64 mac_key, unsigned char *mac_addr)
+{
+	put_unaligned((u16)(mac_key >> 32), (u16 *)mac_addr);
+	put_unaligned((u32)mac_key, (u32 *)(mac_addr + 2));
+}
+
+/* max number of host entries, module parameter */
+extern unsigned int host_capacity;
 
 /* hash table defination */
-extern struct hlist_head g_hash_table[];
+extern struct host_hash_table __rcu *g_hash_table;
 
-/* free table head defination */
-extern struct list_head *g_free_table;
+/* number of hosts in hash table, protected by table lock */
+extern unsigned int g_host_count;
 
-/* recently used table head defination */
+/* recently used table head defination, it's the ring of CLOCK eviction */
 extern struct list_head *g_lru_table;
 
+/* eviction counters, protected by table lock */
+extern unsigned long g_evict_count;
+extern unsigned long g_evict_active_count;
+
 extern struct timer_list data_traffic_timer;
 
-extern void host_entry_data_init(void);
+extern int host_entry_data_init(void);
 
-extern void data_traffic_timer_init(void);
+extern void host_entry_data_exit(void);
+
+extern struct host_entry *alloc_host_entry(int node);
+extern struct host_entry *host_entry_get(void);
+extern void host_entry_put(struct host_entry *host);
+extern bool host_entry_pool_full(void);
+extern unsigned int host_entry_allocated(void);
 
-extern int add_host_entry(unsigned char *mac_addr, unsigned int ip_addr, char *access_device_name);
+extern void data_traffic_timer_init(void);
 
-extern void update_host_stat(unsigned char *mac_addr,
-						unsigned int ip_addr,
+extern unsigned int skb_wire_len(const struct sk_buff *skb, unsigned int *segs);
+extern void update_host_stat(struct host_entry *host,
 						struct sk_buff *skb,
 						int flag,
-						char *access_device_name);
+						int ifindex,
+						u16 vid);
+extern void host_update_ip(struct host_entry *host, unsigned int ip_addr);
+extern void host_update_ip6(struct host_entry *host, const struct in6_addr *ip6_addr);
+extern void host_ip6_reset(struct host_entry *host);
+extern unsigned int host_ip6_read(struct host_entry *host, struct in6_addr *ip6_addr);
 extern void delete_host_entry(struct host_entry *host);
+extern void host_counter_reset(struct host_entry *host);
+extern void host_counter_add(struct host_entry *host, const struct dt_host_record *rec);
+extern void host_stat_fold(struct host_entry *host, struct host_stat *stat);
+extern void host_stat_read(struct host_entry *host, struct host_stat *stat);
+extern void host_class_read(struct host_entry *host, u64 class_bytes[2][HOST_CLASS_NUM]);
+extern void host_rate_reset(struct host_entry *host);
+extern void host_rate_update(struct host_entry *host);
+extern void host_rate_read(struct host_entry *host, struct rate_report *report);
+extern unsigned long host_active_time(struct host_entry *host);
+extern void host_entry_to_record(struct host_entry *host, struct dt_host_record *rec);
 
 #endif
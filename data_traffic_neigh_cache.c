@@ -0,0 +1,223 @@
+/*********************************************************
+* FILE NAME		:	data_traffic_neigh_cache.c
+* VERSION		:	1.0
+* DESCRIPTION	:	Per-CPU cache of IP address to host entry
+*					and bridge port, so that the download path
+*					doesn't look up ARP table and bridge FDB for
+*					every packet. IPv4 addresses are cached as
+*					IPv4-mapped IPv6 addresses.
+*
+*					A neighbour update only invalidates the slot
+*					its address hashes to, on all the CPUs, by
+*					bumping the generation of this slot. A host
+*					entry removal bumps the slots the entry was
+*					cached in. All the slots are invalidated at
+*					once by bumping the global generation, on net
+*					device going away.
+*
+* CREATE DATE	:	17/10/2026
+*********************************************************/
+#include <linux/kernel.h>
+#include <linux/percpu.h>
+#include <linux/hash.h>
+#include <linux/jiffies.h>
+#include <linux/notifier.h>
+#include <linux/netdevice.h>
+#include <net/neighbour.h>
+#include <net/netevent.h>
+#include <net/arp.h>
+#include <net/ipv6.h>
+#include <net/ndisc.h>
+#include "data_traffic_neigh_cache.h"
+
+static DEFINE_PER_CPU(struct neigh_cache_slot [NEIGH_CACHE_SIZE], g_neigh_cache);
+
+/* a slot is valid only if it's filled with the current generation */
+atomic_t g_neigh_cache_gen = ATOMIC_INIT(1);
+
+/* generation of each slot index, shared by the CPUs, see neigh_cache_slot_gen */
+static atomic_t g_neigh_slot_gen[NEIGH_CACHE_SIZE];
+
+static inline unsigned int neigh_cache_index(const struct in6_addr *ip_addr)
+{
+	return hash_32(ipv6_addr_hash(ip_addr), NEIGH_CACHE_BITS);
+}
+
+/**
+ * Generation a slot is filled with. Both generations only grow, so their
+ * sum changes whenever either of them is bumped.
+ */
+static inline unsigned int neigh_cache_slot_gen(unsigned int index)
+{
+	return neigh_cache_gen() + atomic_read(&g_neigh_slot_gen[index]);
+}
+
+/******************************************************
+  Function:     neigh_cache_invalidate
+  Description:  invalidate the cache of all the CPUs
+******************************************************/
+void neigh_cache_invalidate(void)
+{
+	atomic_inc(&g_neigh_cache_gen);
+}
+
+/*************************************************************
+  Function:     neigh_cache_invalidate_host
+  Description:  invalidate on all the CPUs the slots a host entry
+                was cached in. Called after the entry is unlinked
+                and before it is freed.
+  Input:        host, host entry being removed
+*************************************************************/
+void neigh_cache_invalidate_host(struct host_entry *host)
+{
+	unsigned int index;
+
+	/* pairs with the barrier of neigh_cache_update */
+	smp_mb();
+	for_each_set_bit(index, host->neigh_slots, NEIGH_CACHE_SIZE)
+		atomic_inc(&g_neigh_slot_gen[index]);
+	bitmap_zero(host->neigh_slots, NEIGH_CACHE_SIZE);
+}
+
+/* invalidate the slot of one address on all the CPUs */
+static void neigh_cache_invalidate_addr(const struct in6_addr *ip_addr)
+{
+	atomic_inc(&g_neigh_slot_gen[neigh_cache_index(ip_addr)]);
+}
+
+/*************************************************************
+  Function:     neigh_cache_lookup
+  Description:  find host entry and bridge port of an IP
+                address in the cache of local CPU. Called
+                under rcu_read_lock(), the returned entry is
+                valid until rcu_read_unlock().
+  Input:        ip_addr, IPv6 or IPv4-mapped address of the host
+                port, to store the bridge port of the host
+                gen, to store the generation to pass to
+                     neigh_cache_update in case of miss
+  Return:       host entry, NULL in case of miss
+*************************************************************/
+struct host_entry *neigh_cache_lookup(const struct in6_addr *ip_addr,
+						struct net_device **port,
+						unsigned int *gen)
+{
+	unsigned int index = neigh_cache_index(ip_addr);
+	struct neigh_cache_slot *slot = this_cpu_ptr(&g_neigh_cache[index]);
+
+	*gen = neigh_cache_slot_gen(index);
+	if (!ipv6_addr_equal(&slot->ip_addr, ip_addr) || slot->gen != *gen ||
+		slot->host == NULL || time_after(jiffies, slot->expires))
+		return NULL;
+
+	*port = slot->port;
+
+	return slot->host;
+}
+
+/*************************************************************
+  Function:     neigh_cache_update
+  Description:  fill the cache of local CPU after a miss
+  Input:        ip_addr, IPv6 or IPv4-mapped address of the host
+                gen, generation returned by neigh_cache_lookup
+                     before ARP table and FDB were looked up
+                host, host entry of this IP address
+                port, bridge port of this host
+*************************************************************/
+void neigh_cache_update(const struct in6_addr *ip_addr, unsigned int gen,
+						struct host_entry *host, struct net_device *port)
+{
+	unsigned int index = neigh_cache_index(ip_addr);
+	struct neigh_cache_slot *slot = this_cpu_ptr(&g_neigh_cache[index]);
+
+	/**
+	 * Either the removal of this host sees the slot bit and bumps the
+	 * generation read before the lookup, or the entry is seen unlinked here.
+	 */
+	if (!test_bit(index, host->neigh_slots))
+		set_bit(index, host->neigh_slots);
+	smp_mb();
+	if (!ACCESS_ONCE(host->linked))
+		return;
+
+	slot->ip_addr = *ip_addr;
+	slot->gen = gen;
+	slot->expires = jiffies + NEIGH_CACHE_TIMEOUT;
+	slot->host = host;
+	slot->port = port;
+}
+
+static int neigh_cache_netevent(struct notifier_block *nb,
+						unsigned long event, void *ptr)
+{
+	struct neighbour *neighbour = ptr;
+	struct in6_addr ip_addr;
+
+	if (event != NETEVENT_NEIGH_UPDATE)
+		return NOTIFY_DONE;
+
+	/* only the address of this neighbour is dropped from the cache */
+	if (neighbour->tbl == &arp_tbl) {
+		ipv6_addr_set_v4mapped(*(const __be32 *)neighbour->primary_key, &ip_addr);
+		neigh_cache_invalidate_addr(&ip_addr);
+	}
+#if IS_ENABLED(CONFIG_IPV6)
+	else if (neighbour->tbl == &nd_tbl) {
+		neigh_cache_invalidate_addr((const struct in6_addr *)neighbour->primary_key);
+	}
+#endif
+
+	return NOTIFY_DONE;
+}
+
+static int neigh_cache_netdev_event(struct notifier_block *nb,
+						unsigned long event, void *ptr)
+{
+	switch (event) {
+	case NETDEV_DOWN:
+	case NETDEV_CHANGEADDR:
+	case NETDEV_UNREGISTER:
+		neigh_cache_invalidate();
+		break;
+	}
+
+	return NOTIFY_DONE;
+}
+
+static struct notifier_block neigh_cache_netevent_nb = {
+	.notifier_call = neigh_cache_netevent,
+};
+
+static struct notifier_block neigh_cache_netdev_nb = {
+	.notifier_call = neigh_cache_netdev_event,
+};
+
+/*********************************************************
+  Function:     neigh_cache_init
+  Description:  register neighbour and net device notifier
+  Return:       return 0 in case of success,
+                return error code of the notifier chain
+*********************************************************/
+int neigh_cache_init(void)
+{
+	int ret;
+
+	BUILD_BUG_ON(HOST_NEIGH_SLOTS != NEIGH_CACHE_SIZE);
+
+	ret = register_netevent_notifier(&neigh_cache_netevent_nb);
+	if (ret < 0)
+		return ret;
+
+	ret = register_netdevice_notifier(&neigh_cache_netdev_nb);
+	if (ret < 0) {
+		unregister_netevent_notifier(&neigh_cache_netevent_nb);
+		return ret;
+	}
+
+	return 0;
+}
+
+void neigh_cache_exit(void)
+{
+	unregister_netdevice_notifier(&neigh_cache_netdev_nb);
+	unregister_netevent_notifier(&neigh_cache_netevent_nb);
+}
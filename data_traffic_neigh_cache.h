@@ -0,0 +1,53 @@
+/*********************************************************
+* FILE NAME		:	data_traffic_neigh_cache.h
+* VERSION		:	1.0
+* DESCRIPTION	:	Per-CPU cache of IP address to host entry
+*					and bridge port, so that the download path
+*					doesn't look up ARP table and bridge FDB for
+*					every packet. IPv4 addresses are cached as
+*					IPv4-mapped IPv6 addresses.
+*
+* CREATE DATE	:	17/10/2026
+*********************************************************/
+#ifndef _DATA_TRAFFIC_NEIGH_CACHE_H
+#define _DATA_TRAFFIC_NEIGH_CACHE_H
+
+#include <linux/netdevice.h>
+#include <linux/in6.h>
+#include "data_traffic_host_entry.h"
+
+#define NEIGH_CACHE_BITS 6
+#define NEIGH_CACHE_SIZE (1 << NEIGH_CACHE_BITS)
+/* bridge has no FDB notifier, a cached port is trusted for 1 second */
+#define NEIGH_CACHE_TIMEOUT HZ
+
+/* one cached IP address, owned by one CPU */
+struct neigh_cache_slot {
+	struct in6_addr ip_addr;
+	unsigned int gen;
+	unsigned long expires;
+	struct host_entry *host;
+	struct net_device *port;
+};
+
+/* bumped on net device removal, a neighbour update or host removal only bumps its slots */
+extern atomic_t g_neigh_cache_gen;
+
+static inline unsigned int neigh_cache_gen(void)
+{
+	return atomic_read(&g_neigh_cache_gen);
+}
+
+extern int neigh_cache_init(void);
+extern void neigh_cache_exit(void);
+extern void neigh_cache_invalidate(void);
+extern void neigh_cache_invalidate_host(struct host_entry *host);
+extern struct host_entry *neigh_cache_lookup(const struct in6_addr *ip_addr,
+						struct net_device **port,
+						unsigned int *gen);
+extern void neigh_cache_update(const struct in6_addr *ip_addr,
+						unsigned int gen,
+						struct host_entry *host,
+						struct net_device *port);
+
+#endif
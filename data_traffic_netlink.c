@@ -0,0 +1,374 @@
+/*********************************************************
+* FILE NAME		:	data_traffic_netlink.c
+* VERSION		:	1.0
+* DESCRIPTION	:	Generic netlink interface to get one host,
+*					dump all the hosts or only the hosts changed
+*					since a generation.
+*
+*					The generation is the low 32 bits of jiffies
+*					when the request is handled. A host is changed
+*					since a generation if it had traffic after it.
+*					A host dump walks the MAC keys recorded when it
+*					starts, so its parts don't depend on the order
+*					of lru table, which changes under them.
+*
+* CREATE DATE	:	17/10/2026
+*********************************************************/
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/jiffies.h>
+#include <linux/rculist.h>
+#include <linux/if_ether.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/mm.h>
+#include <net/genetlink.h>
+#include "data_traffic_netlink.h"
+#include "data_traffic_host_entry.h"
+#include "data_traffic_tbl_ops.h"
+#include "data_traffic_flow.h"
+
+/* position of a flow dump, state of a host dump */
+#define DUMP_ARG_POS 0
+#define DUMP_ARG_STATE 1
+
+/**
+ * state of a host dump, kept between its parts. The keys are the removed
+ * hosts to report first, then the hosts recorded when the dump started.
+ */
+struct dt_dump_state {
+	u32 generation;
+	unsigned int resync;
+	unsigned int tombstones;
+	unsigned int num;
+	unsigned int pos;
+	u64 keys[0];
+};
+
+static struct genl_family dt_genl_family = {
+	.id = GENL_ID_GENERATE,
+	.hdrsize = 0,
+	.name = DT_GENL_NAME,
+	.version = DT_GENL_VERSION,
+	.maxattr = DT_ATTR_MAX,
+};
+
+static const struct nla_policy dt_genl_policy[DT_ATTR_MAX + 1] = {
+	[DT_ATTR_MAC] = { .type = NLA_BINARY, .len = ETH_ALEN },
+	[DT_ATTR_SINCE_GEN] = { .type = NLA_U32 },
+};
+
+static inline u32 current_generation(void)
+{
+	return (u32)jiffies;
+}
+
+/*************************************************************
+  Function:     dt_fill_host
+  Description:  put one host into a netlink message
+  Input:        skb, message to fill
+                portid, seq, flags, netlink header fields
+                host, which host entry to put
+                generation, generation of this reply
+  Return:       return 0 in case of success,
+                return -EMSGSIZE if the message is full
+*************************************************************/
+static int dt_fill_host(struct sk_buff *skb, u32 portid, u32 seq, int flags,
+						struct host_entry *host, u32 generation)
+{
+	struct dt_host_record rec;
+	struct in6_addr ip6_addr[HOST_IP6_NUM];
+	unsigned int ip6_num, i;
+	void *hdr = NULL;
+
+	hdr = genlmsg_put(skb, portid, seq, &dt_genl_family, flags, DT_CMD_GET_HOST);
+	if (hdr == NULL)
+		return -EMSGSIZE;
+
+	host_entry_to_record(host, &rec);
+	if (nla_put_u32(skb, DT_ATTR_GENERATION, generation) ||
+		nla_put(skb, DT_ATTR_RECORD, sizeof(rec), &rec))
+		goto cancel;
+
+	ip6_num = host_ip6_read(host, ip6_addr);
+	for (i = 0; i < ip6_num; i++) {
+		if (nla_put(skb, DT_ATTR_IP6, sizeof(ip6_addr[i]), &ip6_addr[i]))
+			goto cancel;
+	}
+
+	genlmsg_end(skb, hdr);
+
+	return 0;
+
+cancel:
+	genlmsg_cancel(skb, hdr);
+	return -EMSGSIZE;
+}
+
+/*************************************************************
+  Function:     dt_get_host
+  Description:  DT_CMD_GET_HOST handler, reply with the host
+                of DT_ATTR_MAC
+*************************************************************/
+static int dt_get_host(struct sk_buff *skb, struct genl_info *info)
+{
+	struct host_entry *host = NULL;
+	struct sk_buff *msg = NULL;
+	unsigned char *mac_addr = NULL;
+	int ret;
+
+	if (info->attrs[DT_ATTR_MAC] == NULL ||
+		nla_len(info->attrs[DT_ATTR_MAC]) != ETH_ALEN)
+		return -EINVAL;
+	mac_addr = nla_data(info->attrs[DT_ATTR_MAC]);
+
+	msg = genlmsg_new(NLMSG_DEFAULT_SIZE, GFP_KERNEL);
+	if (msg == NULL)
+		return -ENOMEM;
+
+	rcu_read_lock();
+	host = hlist_find_host_by_mac(mac_addr);
+	if (host == NULL)
+		ret = -ENOENT;
+	else
+		ret = dt_fill_host(msg, info->snd_portid, info->snd_seq, 0,
+					host, current_generation());
+	rcu_read_unlock();
+
+	if (ret < 0) {
+		nlmsg_free(msg);
+		return ret;
+	}
+
+	return genlmsg_reply(msg, info);
+}
+
+/* put a removed host, or the resync flag if mac_key is NULL */
+static int dt_fill_tombstone(struct sk_buff *skb, u32 portid, u32 seq,
+						const u64 *mac_key, u32 generation)
+{
+	unsigned char mac_addr[ETH_ALEN];
+	void *hdr = NULL;
+
+	hdr = genlmsg_put(skb, portid, seq, &dt_genl_family, NLM_F_MULTI,
+				mac_key != NULL ? DT_CMD_DEL_HOST : DT_CMD_GET_HOST);
+	if (hdr == NULL)
+		return -EMSGSIZE;
+
+	if (nla_put_u32(skb, DT_ATTR_GENERATION, generation))
+		goto cancel;
+	if (mac_key != NULL) {
+		key_to_mac(*mac_key, mac_addr);
+		if (nla_put(skb, DT_ATTR_MAC, ETH_ALEN, mac_addr))
+			goto cancel;
+	} else if (nla_put_flag(skb, DT_ATTR_RESYNC)) {
+		goto cancel;
+	}
+
+	genlmsg_end(skb, hdr);
+
+	return 0;
+
+cancel:
+	genlmsg_cancel(skb, hdr);
+	return -EMSGSIZE;
+}
+
+static void dt_dump_state_free(struct dt_dump_state *state)
+{
+	if (is_vmalloc_addr(state))
+		vfree(state);
+	else
+		kfree(state);
+}
+
+/*************************************************************
+  Function:     dt_dump_state_alloc
+  Description:  first part of a host dump, parse the filter and
+                record the removed hosts and the MAC keys of
+                the hosts to put
+  Return:       the dump state, NULL if out of memory
+*************************************************************/
+static struct dt_dump_state *dt_dump_state_alloc(struct netlink_callback *cb)
+{
+	struct nlattr *attrs[DT_ATTR_MAX + 1];
+	struct dt_dump_state *state = NULL;
+	struct host_entry *host = NULL;
+	unsigned int max = HOST_TOMBSTONE_NUM + host_capacity;
+	size_t size = sizeof(*state) + max * sizeof(u64);
+	int filter = 0;
+	u32 since = 0;
+	int ret;
+
+	if (size > PAGE_SIZE)
+		state = vmalloc(size);
+	else
+		state = kmalloc(size, GFP_KERNEL);
+	if (state == NULL)
+		return NULL;
+
+	memset(state, 0, sizeof(*state));
+	state->generation = current_generation();
+	if (nlmsg_parse(cb->nlh, GENL_HDRLEN + dt_genl_family.hdrsize, attrs,
+			DT_ATTR_MAX, dt_genl_policy) == 0 &&
+		attrs[DT_ATTR_SINCE_GEN] != NULL) {
+		since = nla_get_u32(attrs[DT_ATTR_SINCE_GEN]);
+		filter = 1;
+	}
+
+	if (filter) {
+		ret = host_tombstones_read(since, state->keys, HOST_TOMBSTONE_NUM);
+		if (ret < 0) {
+			/* removals are lost, the consumer needs all the hosts */
+			state->resync = 1;
+			filter = 0;
+		} else {
+			state->tombstones = ret;
+			state->num = ret;
+		}
+	}
+
+	rcu_read_lock();
+	list_for_each_entry_rcu(host, g_lru_table, lru_tbl_node) {
+		if (state->num == max)
+			break;
+
+		if (filter && (s32)((u32)host_active_time(host) - since) < 0)
+			continue;
+
+		state->keys[state->num++] = host->mac_key;
+	}
+	rcu_read_unlock();
+
+	return state;
+}
+
+/*************************************************************
+  Function:     dt_dump_host
+  Description:  DT_CMD_GET_HOST dump handler, put the removed
+                hosts then all the hosts or the hosts changed
+                since DT_ATTR_SINCE_GEN, continues from where
+                the last part stopped. A host removed since the
+                dump started is skipped, the next delta dump
+                reports its removal.
+*************************************************************/
+static int dt_dump_host(struct sk_buff *skb, struct netlink_callback *cb)
+{
+	struct dt_dump_state *state = (struct dt_dump_state *)cb->args[DUMP_ARG_STATE];
+	unsigned char mac_addr[ETH_ALEN];
+	struct host_entry *host = NULL;
+	u32 portid = NETLINK_CB(cb->skb).portid;
+	u32 seq = cb->nlh->nlmsg_seq;
+	int ret;
+
+	if (state == NULL) {
+		state = dt_dump_state_alloc(cb);
+		if (state == NULL)
+			return -ENOMEM;
+		cb->args[DUMP_ARG_STATE] = (long)state;
+	}
+
+	if (state->resync) {
+		if (dt_fill_tombstone(skb, portid, seq, NULL, state->generation) < 0)
+			return skb->len;
+		state->resync = 0;
+	}
+
+	while (state->pos < state->num) {
+		ret = 0;
+		if (state->pos < state->tombstones) {
+			ret = dt_fill_tombstone(skb, portid, seq, &state->keys[state->pos],
+						state->generation);
+		} else {
+			key_to_mac(state->keys[state->pos], mac_addr);
+			rcu_read_lock();
+			host = hlist_find_host_by_mac(mac_addr);
+			if (host != NULL)
+				ret = dt_fill_host(skb, portid, seq, NLM_F_MULTI, host,
+							state->generation);
+			rcu_read_unlock();
+		}
+		if (ret < 0)
+			break;
+
+		state->pos++;
+	}
+
+	return skb->len;
+}
+
+/* end of a host dump, free its state */
+static int dt_dump_host_done(struct netlink_callback *cb)
+{
+	struct dt_dump_state *state = (struct dt_dump_state *)cb->args[DUMP_ARG_STATE];
+
+	if (state != NULL)
+		dt_dump_state_free(state);
+	cb->args[DUMP_ARG_STATE] = 0;
+
+	return 0;
+}
+
+/*************************************************************
+  Function:     dt_dump_flow
+  Description:  DT_CMD_GET_FLOW dump handler, put all the flows
+                of all the CPUs, one DT_ATTR_FLOW per message
+*************************************************************/
+static int dt_dump_flow(struct sk_buff *skb, struct netlink_callback *cb)
+{
+	struct dt_flow_record rec;
+	long pos = cb->args[DUMP_ARG_POS];
+	void *hdr = NULL;
+
+	while ((pos = flow_read_next(pos, &rec)) >= 0) {
+		hdr = genlmsg_put(skb, NETLINK_CB(cb->skb).portid, cb->nlh->nlmsg_seq,
+				&dt_genl_family, NLM_F_MULTI, DT_CMD_GET_FLOW);
+		if (hdr == NULL)
+			break;
+		if (nla_put(skb, DT_ATTR_FLOW, sizeof(rec), &rec)) {
+			genlmsg_cancel(skb, hdr);
+			break;
+		}
+		genlmsg_end(skb, hdr);
+		pos++;
+	}
+
+	/* stop at the flow which didn't fit, or past the end */
+	cb->args[DUMP_ARG_POS] = pos < 0 ? LONG_MAX : pos;
+
+	return skb->len;
+}
+
+static struct genl_ops dt_genl_ops[] = {
+	{
+		.cmd = DT_CMD_GET_HOST,
+		.flags = GENL_ADMIN_PERM,
+		.policy = dt_genl_policy,
+		.doit = dt_get_host,
+		.dumpit = dt_dump_host,
+		.done = dt_dump_host_done,
+	},
+	{
+		.cmd = DT_CMD_GET_FLOW,
+		.flags = GENL_ADMIN_PERM,
+		.dumpit = dt_dump_flow,
+	},
+};
+
+/**********************************************
+  Function:     data_traffic_netlink_init
+  Description:  register the generic netlink
+                family and its operations
+  Return:       return 0 in case of success,
+                return error code of genetlink
+**********************************************/
+int data_traffic_netlink_init(void)
+{
+	return genl_register_family_with_ops(&dt_genl_family, dt_genl_ops,
+						ARRAY_SIZE(dt_genl_ops));
+}
+
+void data_traffic_netlink_exit(void)
+{
+	genl_unregister_family(&dt_genl_family);
+}
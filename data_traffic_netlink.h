@@ -0,0 +1,18 @@
+/*********************************************************
+* FILE NAME		:	data_traffic_netlink.h
+* VERSION		:	1.0
+* DESCRIPTION	:	Generic netlink interface to get one host,
+*					dump all the hosts or only the hosts changed
+*					since a generation.
+*
+* CREATE DATE	:	17/10/2026
+*********************************************************/
+#ifndef _DATA_TRAFFIC_NETLINK_H
+#define _DATA_TRAFFIC_NETLINK_H
+
+#include "data_traffic_export.h"
+
+extern int data_traffic_netlink_init(void);
+extern void data_traffic_netlink_exit(void);
+
+#endif
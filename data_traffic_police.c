@@ -0,0 +1,287 @@
+/*********************************************************
+* FILE NAME		:	data_traffic_police.c
+* VERSION		:	1.0
+* DESCRIPTION	:	Per-host policer.
+*
+*					A packet is accepted if the theoretical arrival
+*					time of its direction is less than tau ahead of
+*					now, and the time is advanced by the cost of
+*					the packet. Refill is implied by the clock, no
+*					timer nor lock is involved.
+*
+*					The rules live in a list and a hash keyed by
+*					MAC address, each with the GCRA state of its
+*					MAC. A host entry only caches whether its MAC
+*					has a rule, a host without an entry is looked
+*					up by its MAC while some rule is configured.
+*
+* CREATE DATE	:	17/10/2026
+*********************************************************/
+#include <linux/kernel.h>
+#include <linux/string.h>
+#include <linux/mutex.h>
+#include <linux/slab.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/rculist.h>
+#include <linux/hash.h>
+#include <linux/if_ether.h>
+#include <linux/netfilter.h>
+#include <asm/cmpxchg.h>
+#include "data_traffic_police.h"
+#include "data_traffic_host_entry.h"
+#include "data_traffic_tbl_ops.h"
+
+LIST_HEAD(g_police_rules);
+static struct hlist_head g_police_hash[1 << POLICE_HASH_BITS];
+static DEFINE_MUTEX(g_police_mutex);
+static unsigned int g_police_rule_num;
+
+/* find the rule of a MAC, under rcu_read_lock() or the police mutex */
+static struct police_rule *police_rule_find(u64 mac_key)
+{
+	struct hlist_head *head = &g_police_hash[hash_64(mac_key, POLICE_HASH_BITS)];
+	struct police_rule *rule = NULL;
+
+	hlist_for_each_entry_rcu(rule, head, hash_node) {
+		if (rule->mac_key == mac_key)
+			return rule;
+	}
+
+	return NULL;
+}
+
+/*************************************************************
+  Function:     police_packet
+  Description:  GCRA check of a packet against the rule of its
+                MAC, if any. No accepted packet takes the
+                theoretical arrival time more than tau plus the
+                largest cost ahead of now, beyond that it's a
+                stale one that wrapped around, restart from now.
+                The bound doesn't depend on the packet, a small
+                packet after a large one is checked like any
+                other. Called under rcu_read_lock().
+  Input:        mac_key, MAC address of the host, see mac_to_key
+                skb, the packet
+                direction, INBOUND or OUTBOUND
+  Return:       true to accept the packet, false to drop it
+*************************************************************/
+bool police_packet(u64 mac_key, struct sk_buff *skb, unsigned int direction)
+{
+	struct police_rule *rule = police_rule_find(mac_key);
+	struct host_policer *p = NULL;
+	u32 now, tat, old, cost, tau, limit;
+	unsigned int segs = 0;
+	s32 ahead;
+
+	if (rule == NULL)
+		return true;
+
+	p = &rule->police;
+	if (p->cost[direction] == 0)
+		return true;
+
+	tau = p->tau[direction];
+	limit = tau + p->max_cost[direction];
+	cost = min_t(u64, ((u64)skb_wire_len(skb, &segs) * p->cost[direction]) >> 16,
+			p->max_cost[direction]);
+	now = (u32)ktime_to_us(ktime_get());
+	old = ACCESS_ONCE(p->tat[direction]);
+
+	for (;;) {
+		ahead = (s32)(old - now);
+		if (ahead < 0 || ahead > (s32)limit)
+			tat = now;
+		else if (ahead > (s32)tau)
+			return false;
+		else
+			tat = old;
+
+		tat = cmpxchg(&p->tat[direction], old, tat + cost);
+		if (tat == old)
+			return true;
+		old = tat;
+	}
+}
+
+/*************************************************************
+  Function:     police_apply
+  Description:  mark a host entry policed if its MAC has a rule,
+                so that the packet path only looks up the rules
+                of the hosts that have one. Called with the table
+                lock held, see police_apply_mac.
+  Input:        host, host entry to set
+*************************************************************/
+void police_apply(struct host_entry *host)
+{
+	host->policed = police_rule_find(host->mac_key) != NULL;
+}
+
+/*************************************************************
+  Function:     police_rule_init
+  Description:  set the GCRA parameters of a new rule. The
+                theoretical arrival time goes on from the rule
+                it replaces, a rule written again gives no fresh
+                burst.
+  Input:        rule, new rule, not published yet
+                old, rule of the same MAC in use, may be NULL
+*************************************************************/
+static void police_rule_init(struct police_rule *rule, struct police_rule *old)
+{
+	struct host_policer *p = &rule->police;
+	u32 now = (u32)ktime_to_us(ktime_get());
+	u32 dir;
+
+	/* the stale check of police_packet needs the largest ahead below 2^31 */
+	BUILD_BUG_ON((u64)POLICE_MAX_TAU +
+		(u64)POLICE_MAX_PACKET * USEC_PER_SEC / POLICE_MIN_RATE >= (1ULL << 31));
+
+	for (dir = 0; dir < 2; dir++) {
+		if (rule->rate[dir] == 0)
+			continue;
+		p->cost[dir] = div_u64((u64)USEC_PER_SEC << 16, rule->rate[dir]);
+		p->tau[dir] = min_t(u64, POLICE_MAX_TAU,
+				div_u64((u64)rule->burst * USEC_PER_SEC, rule->rate[dir]));
+		p->max_cost[dir] = ((u64)POLICE_MAX_PACKET * p->cost[dir]) >> 16;
+		p->tat[dir] = old != NULL ? ACCESS_ONCE(old->police.tat[dir]) : now;
+	}
+}
+
+/*************************************************************
+  Function:     police_rule_set
+  Description:  add, change or remove the rule of a MAC, then
+                apply it to the host entry of this MAC.
+                Called with the police mutex held.
+  Input:        mac_addr, MAC address of the host
+                rate, download and upload rate in bytes per
+                      second, both 0 removes the rule
+                burst, bytes accepted at once
+  Return:       return 0 in case of success,
+                return -ENOSPC if there are too many rules,
+                return -ENOMEM if out of memory
+*************************************************************/
+static int police_rule_set(unsigned char *mac_addr, u32 rate[2], u32 burst)
+{
+	struct police_rule *rule = police_rule_find(mac_to_key(mac_addr));
+	struct police_rule *new_rule = NULL;
+
+	if (rate[INBOUND] == 0 && rate[OUTBOUND] == 0) {
+		if (rule != NULL) {
+			list_del_rcu(&rule->list);
+			hlist_del_rcu(&rule->hash_node);
+			kfree_rcu(rule, rcu);
+			g_police_rule_num--;
+		}
+		goto apply;
+	}
+
+	if (rule == NULL && g_police_rule_num == POLICE_RULE_MAX)
+		return -ENOSPC;
+
+	new_rule = kzalloc(sizeof(*new_rule), GFP_KERNEL);
+	if (new_rule == NULL)
+		return -ENOMEM;
+	new_rule->mac_key = mac_to_key(mac_addr);
+	new_rule->rate[INBOUND] = rate[INBOUND];
+	new_rule->rate[OUTBOUND] = rate[OUTBOUND];
+	new_rule->burst = burst;
+	police_rule_init(new_rule, rule);
+
+	if (rule != NULL) {
+		list_replace_rcu(&rule->list, &new_rule->list);
+		hlist_replace_rcu(&rule->hash_node, &new_rule->hash_node);
+		kfree_rcu(rule, rcu);
+	} else {
+		list_add_rcu(&new_rule->list, &g_police_rules);
+		hlist_add_head_rcu(&new_rule->hash_node,
+				&g_police_hash[hash_64(new_rule->mac_key, POLICE_HASH_BITS)]);
+		g_police_rule_num++;
+	}
+
+apply:
+	/* under the table lock, a host being recorded can't miss the rule */
+	police_apply_mac(mac_addr);
+
+	return 0;
+}
+
+/*************************************************************
+  Function:     police_rules_write
+  Description:  set the rules of a list of MAC addresses, one
+                per line: "<MAC> <download> <upload> [burst]",
+                rates in bytes per second, "0 0" removes it.
+                Called in process context.
+  Input:        rules, NUL terminated
+  Return:       return 0 in case of success,
+                return -EINVAL for a malformed line,
+                error code of police_rule_set otherwise
+*************************************************************/
+int police_rules_write(const char *rules)
+{
+	unsigned char mac_addr[ETH_ALEN];
+	unsigned int mac[ETH_ALEN];
+	u32 rate[2], burst;
+	char line[80];
+	const char *end = NULL;
+	int ret = 0;
+	int n, i;
+
+	mutex_lock(&g_police_mutex);
+
+	while (*rules != '\0') {
+		end = strchrnul(rules, '\n');
+		if (end - rules >= sizeof(line)) {
+			ret = -EINVAL;
+			break;
+		}
+		memcpy(line, rules, end - rules);
+		line[end - rules] = '\0';
+		rules = *end == '\0' ? end : end + 1;
+
+		if (*skip_spaces(line) == '\0')
+			continue;
+
+		burst = POLICE_DEFAULT_BURST;
+		n = sscanf(line, "%x:%x:%x:%x:%x:%x %u %u %u",
+				&mac[0], &mac[1], &mac[2], &mac[3], &mac[4], &mac[5],
+				&rate[INBOUND], &rate[OUTBOUND], &burst);
+		if (n < 8 || burst == 0) {
+			ret = -EINVAL;
+			break;
+		}
+		for (i = 0; i < ETH_ALEN; i++) {
+			if (mac[i] > 0xff) {
+				ret = -EINVAL;
+				goto unlock;
+			}
+			mac_addr[i] = mac[i];
+		}
+		if ((rate[INBOUND] != 0 && rate[INBOUND] < POLICE_MIN_RATE) ||
+			(rate[OUTBOUND] != 0 && rate[OUTBOUND] < POLICE_MIN_RATE)) {
+			ret = -EINVAL;
+			break;
+		}
+
+		ret = police_rule_set(mac_addr, rate, burst);
+		if (ret < 0)
+			break;
+	}
+
+unlock:
+	mutex_unlock(&g_police_mutex);
+
+	return ret;
+}
+
+/* free the rules, called once the hooks are unregistered */
+void police_exit(void)
+{
+	struct police_rule *rule = NULL, *temp = NULL;
+
+	list_for_each_entry_safe(rule, temp, &g_police_rules, list) {
+		list_del(&rule->list);
+		hlist_del(&rule->hash_node);
+		kfree(rule);
+	}
+	g_police_rule_num = 0;
+}
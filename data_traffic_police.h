@@ -0,0 +1,79 @@
+/*********************************************************
+* FILE NAME		:	data_traffic_police.h
+* VERSION		:	1.0
+* DESCRIPTION	:	Per-host policer, upload and download rate
+*					limit configured per MAC address.
+*
+* CREATE DATE	:	17/10/2026
+*********************************************************/
+#ifndef _DATA_TRAFFIC_POLICE_H
+#define _DATA_TRAFFIC_POLICE_H
+
+#include <linux/types.h>
+#include <linux/list.h>
+#include <linux/rculist.h>
+#include <linux/rcupdate.h>
+#include <linux/skbuff.h>
+
+/* burst of a rule written without one, in bytes */
+#define POLICE_DEFAULT_BURST 65536
+/* lowest rate accepted, bytes per second */
+#define POLICE_MIN_RATE 1000
+#define POLICE_RULE_MAX 256
+/* longest burst tolerance, far below the wrap of the 32 bits clock */
+#define POLICE_MAX_TAU (1U << 28)
+/**
+ * largest wire length charged to one packet, above any GSO packet. With
+ * POLICE_MAX_TAU, the most a theoretical arrival time can be ahead of
+ * now stays below the wrap of the clock.
+ */
+#define POLICE_MAX_PACKET (128 * 1024)
+/* buckets of the rule hash, power of 2 */
+#define POLICE_HASH_BITS 6
+
+/**
+ * GCRA state of a MAC address, kept in its rule so that a host policed
+ * with or without a host entry, or with a new entry after an eviction,
+ * never gets a fresh burst. tat is the theoretical arrival time in
+ * microseconds, advanced with cmpxchg by the CPU accepting a packet.
+ * cost and tau are set before the rule is published. A rate of 0
+ * doesn't limit the direction.
+ */
+struct host_policer {
+	u32 tat[2];
+	/* microseconds per byte, fixed point << 16 */
+	u32 cost[2];
+	/* burst tolerance in microseconds */
+	u32 tau[2];
+	/* cost of POLICE_MAX_PACKET, the cost of a packet is capped to it */
+	u32 max_cost[2];
+};
+
+/* configured limit of a MAC address, bytes per second */
+struct police_rule {
+	struct list_head list;
+	struct hlist_node hash_node;
+	struct rcu_head rcu;
+	u64 mac_key;
+	u32 rate[2];
+	u32 burst;
+	struct host_policer police;
+};
+
+struct host_entry;
+
+/* configured rules, RCU list, written with the police mutex held */
+extern struct list_head g_police_rules;
+
+/* true if some rule is configured, checked before any rule lookup */
+static inline bool police_enabled(void)
+{
+	return !list_empty(&g_police_rules);
+}
+
+extern bool police_packet(u64 mac_key, struct sk_buff *skb, unsigned int direction);
+extern void police_apply(struct host_entry *host);
+extern int police_rules_write(const char *rules);
+extern void police_exit(void);
+
+#endif
@@ -0,0 +1,189 @@
+/*********************************************************
+* FILE NAME		:	data_traffic_port.c
+* VERSION		:	1.0
+* DESCRIPTION	:	Per-CPU traffic counters of each bridge port
+*					and each VLAN.
+*
+*					A port is known by its ifindex. Each CPU has a
+*					small open addressing table per kind, the packet
+*					path finds the slot of its port and VLAN in a
+*					few probes and takes no lock. Readers merge the
+*					slots of all the CPUs by key.
+*
+*					The packets are counted along with their host,
+*					tracked or not, so the totals leave out what
+*					can't be put down to a host: no neighbour, no
+*					bridge port, or dropped by the policer.
+*
+* CREATE DATE	:	17/10/2026
+*********************************************************/
+#include <linux/kernel.h>
+#include <linux/percpu.h>
+#include <linux/cpumask.h>
+#include <linux/string.h>
+#include <linux/if_vlan.h>
+#include "data_traffic_port.h"
+
+static DEFINE_PER_CPU(struct port_stats, g_port_stats);
+
+/**************************************************************
+  Function:     port_vlan_id
+  Description:  get the VLAN of a packet, from the tag of the
+                skb or else from the VLAN device it goes through.
+                In forward mode the LAN side device is the
+                bridge, or a VLAN on top of it, and the VLAN of
+                a bridge port, a VLAN device enslaved to the
+                bridge, is only seen on the port. A VLAN only
+                filtered inside the bridge is not seen there,
+                it's counted as untagged.
+  Input:        skb, packet being counted
+                dev, LAN side device of the packet, may be NULL
+                port, bridge port of the host, may be NULL
+  Return:       VLAN ID, 0 if untagged
+**************************************************************/
+u16 port_vlan_id(const struct sk_buff *skb, struct net_device *dev,
+						struct net_device *port)
+{
+	if (vlan_tx_tag_present(skb))
+		return vlan_tx_tag_get(skb) & VLAN_VID_MASK;
+
+#if IS_ENABLED(CONFIG_VLAN_8021Q)
+	if (dev != NULL && is_vlan_dev(dev))
+		return vlan_dev_vlan_id(dev);
+	if (port != NULL && is_vlan_dev(port))
+		return vlan_dev_vlan_id(port);
+#endif
+
+	return 0;
+}
+
+/* find the slot of a key, take a free one for a new key, NULL if none */
+static inline struct port_counter *port_slot(struct port_counter *tbl,
+						unsigned int size, int key)
+{
+	unsigned int n = (unsigned int)key & (size - 1);
+	unsigned int i;
+
+	for (i = 0; i < PORT_PROBES; i++, n = (n + 1) & (size - 1)) {
+		if (tbl[n].key == key)
+			return &tbl[n];
+		if (tbl[n].key == 0) {
+			tbl[n].key = key;
+			return &tbl[n];
+		}
+	}
+
+	return NULL;
+}
+
+static inline void port_counter_inc(struct port_counter *counter, int dir,
+						unsigned int len, unsigned int segs)
+{
+	counter->bytes[dir] += len;
+	counter->packets[dir] += segs;
+}
+
+/**************************************************************
+  Function:     port_account
+  Description:  count a packet for its port and its VLAN on the
+                local CPU. Called in softirq.
+  Input:        ifindex, bridge port of the host
+                vid, VLAN of the packet, 0 if untagged
+                dir, INBOUND or OUTBOUND
+                len, segs, bytes and segments on the wire
+**************************************************************/
+void port_account(int ifindex, u16 vid, int dir, unsigned int len, unsigned int segs)
+{
+	struct port_stats *stats = this_cpu_ptr(&g_port_stats);
+	struct port_counter *counter = NULL;
+
+	u64_stats_update_begin(&stats->syncp);
+
+	counter = port_slot(stats->port, PORT_SLOTS, ifindex);
+	if (unlikely(counter == NULL)) {
+		counter = &stats->other[PORT_KIND_PORT];
+		counter->key = PORT_KEY_OTHER;
+	}
+	port_counter_inc(counter, dir, len, segs);
+
+	counter = port_slot(stats->vlan, VLAN_SLOTS, vid + 1);
+	if (unlikely(counter == NULL)) {
+		counter = &stats->other[PORT_KIND_VLAN];
+		counter->key = PORT_KEY_OTHER;
+	}
+	port_counter_inc(counter, dir, len, segs);
+
+	u64_stats_update_end(&stats->syncp);
+}
+
+static inline void port_counter_add(struct port_counter *sum, const struct port_counter *counter)
+{
+	sum->bytes[0] += counter->bytes[0];
+	sum->bytes[1] += counter->bytes[1];
+	sum->packets[0] += counter->packets[0];
+	sum->packets[1] += counter->packets[1];
+}
+
+/*************************************************************
+  Function:     port_table_read
+  Description:  merge the slots of all the CPUs by key. Keys
+                beyond the room of sum, and the traffic no CPU
+                had a slot for, are reported as PORT_KEY_OTHER
+                in the last one. Called in process context.
+  Input:        kind, ports or VLANs
+                sum, to store at most n counters
+                n, size of sum, at least 1
+  Return:       number of counters stored
+*************************************************************/
+int port_table_read(enum port_kind kind, struct port_counter *sum, int n)
+{
+	unsigned int size = kind == PORT_KIND_PORT ? PORT_SLOTS : VLAN_SLOTS;
+	struct port_counter other = { .key = PORT_KEY_OTHER };
+	struct port_stats *stats = NULL;
+	struct port_counter *tbl = NULL;
+	struct port_counter slot;
+	unsigned int start, i;
+	int num = 0;
+	int cpu, j;
+
+	for_each_possible_cpu(cpu) {
+		stats = per_cpu_ptr(&g_port_stats, cpu);
+		tbl = kind == PORT_KIND_PORT ? stats->port : stats->vlan;
+
+		/* the slot after the table is the other counter */
+		for (i = 0; i <= size; i++) {
+			do {
+				start = u64_stats_fetch_begin_bh(&stats->syncp);
+				slot = i < size ? tbl[i] : stats->other[kind];
+			} while (u64_stats_fetch_retry_bh(&stats->syncp, start));
+
+			if (slot.key == 0)
+				continue;
+			if (slot.key == PORT_KEY_OTHER) {
+				port_counter_add(&other, &slot);
+				continue;
+			}
+
+			/* a key may have a slot on several CPUs */
+			for (j = 0; j < num; j++) {
+				if (sum[j].key == slot.key)
+					break;
+			}
+			if (j == num) {
+				if (num == n - 1) {
+					port_counter_add(&other, &slot);
+					continue;
+				}
+				memset(&sum[num], 0, sizeof(sum[num]));
+				sum[num].key = slot.key;
+				num++;
+			}
+			port_counter_add(&sum[j], &slot);
+		}
+	}
+
+	if (other.packets[0] != 0 || other.packets[1] != 0)
+		sum[num++] = other;
+
+	return num;
+}
@@ -0,0 +1,61 @@
+/*********************************************************
+* FILE NAME		:	data_traffic_port.h
+* VERSION		:	1.0
+* DESCRIPTION	:	Aggregate traffic of each bridge port and each
+*					VLAN, counted along with the host counters so
+*					the totals of an interface are read without
+*					summing all the hosts.
+*
+* CREATE DATE	:	17/10/2026
+*********************************************************/
+#ifndef _DATA_TRAFFIC_PORT_H
+#define _DATA_TRAFFIC_PORT_H
+
+#include <linux/types.h>
+#include <linux/skbuff.h>
+#include <linux/netdevice.h>
+#include <linux/u64_stats_sync.h>
+
+/* slots of each CPU, power of 2 */
+#define PORT_SLOTS 32
+#define VLAN_SLOTS 64
+/* slots tried for a key before it's counted as other */
+#define PORT_PROBES 4
+/* key of the traffic counted in no slot */
+#define PORT_KEY_OTHER (-1)
+
+enum port_kind {
+	PORT_KIND_PORT,
+	PORT_KIND_VLAN,
+	PORT_KIND_NUM,
+};
+
+/**
+ * traffic of one port or VLAN, indexed by INBOUND/OUTBOUND. The key is
+ * the ifindex of a port or the VLAN ID + 1 (untagged is VLAN 0), 0 for a
+ * free slot.
+ */
+struct port_counter {
+	int key;
+	u64 bytes[2];
+	u64 packets[2];
+};
+
+/**
+ * counters of one CPU, only written by the owning CPU. A slot is taken by
+ * the first key hashed to it and never released, a port removed keeps its
+ * totals until the module is unloaded.
+ */
+struct port_stats {
+	struct u64_stats_sync syncp;
+	struct port_counter port[PORT_SLOTS];
+	struct port_counter vlan[VLAN_SLOTS];
+	struct port_counter other[PORT_KIND_NUM];
+};
+
+extern u16 port_vlan_id(const struct sk_buff *skb, struct net_device *dev,
+						struct net_device *port);
+extern void port_account(int ifindex, u16 vid, int dir, unsigned int len, unsigned int segs);
+extern int port_table_read(enum port_kind kind, struct port_counter *sum, int n);
+
+#endif
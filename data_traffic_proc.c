@@ -14,10 +14,21 @@
 #include <linux/ip.h>
 #include <linux/in.h>
 #include <linux/list.h>
+#include <linux/rculist.h>
 #include <linux/jiffies.h>
+#include <linux/slab.h>
+#include <linux/uaccess.h>
+#include <linux/err.h>
+#include <linux/netdevice.h>
+#include <net/net_namespace.h>
 #include "data_traffic_proc.h"
 #include "data_traffic_host_entry.h"
 #include "data_traffic_tbl_ops.h"
+#include "data_traffic_flow.h"
+#include "data_traffic_class.h"
+#include "data_traffic_sketch.h"
+#include "data_traffic_police.h"
+#include "data_traffic_port.h"
 
 static void *proc_seq_start(struct seq_file *m, loff_t *pos);
 static void *proc_seq_next(struct seq_file *m, void *v, loff_t *pos);
@@ -45,10 +56,9 @@ static void dump_ip_addr(struct seq_file *m, unsigned int ip_addr)
 ************************************************/
 static void dump_mac_addr(struct seq_file *m, unsigned char *mac_addr)
 {
-	if (mac_addr == NULL) {
-		printk(KERN_ERR "Parameter error, MAC address is NULL\n");
+	/* called for every host of a read, no log here */
+	if (mac_addr == NULL)
 		return;
-	}
 
     seq_printf(m, "%02X:%02X:%02X:%02X:%02X:%02X\t", mac_addr[0],
             mac_addr[1], mac_addr[2], mac_addr[3], mac_addr[4], mac_addr[5]);
@@ -57,39 +67,54 @@ static void dump_mac_addr(struct seq_file *m, unsigned char *mac_addr)
 /************************************************************
   Function:     dump_host_entry
   Description:  output the host information, including IP/MAC
-                address, download/upload speed and total data
-                count.
+                address, download/upload speed, total data
+                count and the name of its bridge port, looked
+                up from the ifindex under rcu_read_lock().
   Input:        m, to which seq_file to output
                 host, which host entry to output
 ************************************************************/
 static void dump_host_entry(struct seq_file *m, struct host_entry *host)
 {
+	struct net_device *dev = NULL;
+	struct host_stat stat;
+
 	if (host == NULL)
 		return;
 
-	dump_mac_addr(m, host->info.mac_addr);
+	/* totals and speed are computed at read time */
+	host_stat_read(host, &stat);
+
+	dump_mac_addr(m, host->mac_addr);
 
 	dump_ip_addr(m, host->info.ip_addr);
 
-	seq_printf(m, "%d\t", host->stat.download_speed);
-	seq_printf(m, "%d\t", host->stat.upload_speed);
-	seq_printf(m, "%llu\t", host->stat.download_total);
-	seq_printf(m, "%llu\t", host->stat.upload_total);
-	seq_printf(m, "%s\n", host->info.access_device_name);
+	seq_printf(m, "%u\t", stat.download_speed);
+	seq_printf(m, "%u\t", stat.upload_speed);
+	seq_printf(m, "%llu\t", stat.download_total);
+	seq_printf(m, "%llu\t", stat.upload_total);
+	dev = dev_get_by_index_rcu(&init_net, ACCESS_ONCE(host->info.ifindex));
+	seq_printf(m, "%s\n", dev != NULL ? dev->name : "-");
 }
 
 /***********************************************************
   Function:     proc_seq_start
   Description:  iteration functions, return parameter passed
-                to "next" function
+                to "next" function. lru table is walked under
+                rcu_read_lock(), released in "stop" function
   Input:        pos, iterator position
 ************************************************************/
 static void *proc_seq_start(struct seq_file *m, loff_t *pos)
 {
-    if (*pos >= table_size(g_lru_table))
-		return NULL;
+	struct list_head *temp = NULL;
+	loff_t i = 0;
+
+	rcu_read_lock();
+	list_for_each_rcu(temp, g_lru_table) {
+		if (i++ == *pos)
+			return temp;
+	}
 
-	return g_lru_table->next;
+	return NULL;
 }
 
 /**************************************************************
@@ -100,18 +125,19 @@ static void *proc_seq_start(struct seq_file *m, loff_t *pos)
 ***************************************************************/
 static void *proc_seq_next(struct seq_file *m, void *v, loff_t *pos)
 {
-    struct list_head *temp_entry = (struct list_head *)v;
+	struct list_head *temp_entry = (struct list_head *)v;
+	struct list_head *next = rcu_dereference(list_next_rcu(temp_entry));
 
-    (*pos)++;
-	if (temp_entry->next == g_lru_table)
+	(*pos)++;
+	if (next == g_lru_table)
 		return NULL;
 	else
-		return temp_entry->next;
+		return next;
 }
 
 static void proc_seq_stop(struct seq_file *m, void *v)
 {
-	return;
+	rcu_read_unlock();
 }
 
 /******************************************************
@@ -140,3 +166,396 @@ int proc_seq_open(struct inode *inode, struct file *filp)
 {
 	return seq_open(filp, &proc_seq_ops);
 }
+
+/******************************************************************
+  Function:     proc_rate_seq_show
+  Description:  iteration function, output the rates of a host:
+                MAC address, download bytes/s, upload bytes/s,
+                download packets/s and upload packets/s, each of
+                them over 1s, 10s and 60s
+******************************************************************/
+static int proc_rate_seq_show(struct seq_file *m, void *v)
+{
+	struct list_head *temp = (struct list_head *)v;
+	struct host_entry *host =
+		list_entry(temp, struct host_entry, lru_tbl_node);
+	struct rate_report report;
+	int w;
+
+	host_rate_read(host, &report);
+
+	dump_mac_addr(m, host->mac_addr);
+	for (w = 0; w < RATE_WINDOW_NUM; w++)
+		seq_printf(m, "%u\t", report.bytes[INBOUND][w]);
+	for (w = 0; w < RATE_WINDOW_NUM; w++)
+		seq_printf(m, "%u\t", report.bytes[OUTBOUND][w]);
+	for (w = 0; w < RATE_WINDOW_NUM; w++)
+		seq_printf(m, "%u\t", report.packets[INBOUND][w]);
+	for (w = 0; w < RATE_WINDOW_NUM; w++)
+		seq_printf(m, "%u%c", report.packets[OUTBOUND][w],
+				w == RATE_WINDOW_NUM - 1 ? '\n' : '\t');
+
+	return 0;
+}
+
+static const struct seq_operations proc_rate_seq_ops = {
+	.start = proc_seq_start,
+	.next = proc_seq_next,
+	.stop = proc_seq_stop,
+	.show = proc_rate_seq_show,
+};
+
+int proc_rate_seq_open(struct inode *inode, struct file *filp)
+{
+	return seq_open(filp, &proc_rate_seq_ops);
+}
+
+/*************************************************************
+  Function:     proc_hash_show
+  Description:  output the hash table size, number of hosts,
+                host entries allocated, eviction counters and the histogram of bucket
+                chain length, to check the hash distribution
+*************************************************************/
+static int proc_hash_show(struct seq_file *m, void *v)
+{
+	unsigned int hist[HASH_HISTOGRAM_SIZE];
+	unsigned int size, i;
+
+	rcu_read_lock();
+	size = hash_table_histogram(hist);
+	rcu_read_unlock();
+
+	seq_printf(m, "buckets\t%u\n", size);
+	seq_printf(m, "hosts\t%u\n", ACCESS_ONCE(g_host_count));
+	seq_printf(m, "allocated\t%u\n", host_entry_allocated());
+	seq_printf(m, "evictions\t%lu\n", ACCESS_ONCE(g_evict_count));
+	seq_printf(m, "active_evictions\t%lu\n", ACCESS_ONCE(g_evict_active_count));
+	for (i = 0; i < HASH_HISTOGRAM_SIZE - 1; i++)
+		seq_printf(m, "chain_%u\t%u\n", i, hist[i]);
+	seq_printf(m, "chain_%u+\t%u\n", i, hist[i]);
+
+	return 0;
+}
+
+int proc_hash_open(struct inode *inode, struct file *filp)
+{
+	return single_open(filp, proc_hash_show, NULL);
+}
+
+/* flow seq_file, the private buffer holds the flow being output */
+static void *proc_flow_seq_start(struct seq_file *m, loff_t *pos)
+{
+	long next = flow_read_next(*pos, m->private);
+
+	if (next < 0)
+		return NULL;
+	*pos = next;
+
+	return m->private;
+}
+
+static void *proc_flow_seq_next(struct seq_file *m, void *v, loff_t *pos)
+{
+	long next = flow_read_next(*pos + 1, m->private);
+
+	if (next < 0) {
+		*pos = *pos + 1;
+		return NULL;
+	}
+	*pos = next;
+
+	return m->private;
+}
+
+static void proc_flow_seq_stop(struct seq_file *m, void *v)
+{
+}
+
+/*********************************************
+  Function:     dump_flow_addr
+  Description:  output an address and port of
+                a flow
+**********************************************/
+static void dump_flow_addr(struct seq_file *m, struct dt_flow_record *rec,
+						__u8 *addr, __u16 port)
+{
+	if (rec->family == AF_INET)
+		seq_printf(m, "%pI4:%u\t", addr + 12, ntohs(port));
+	else
+		seq_printf(m, "[%pI6c]:%u\t", addr, ntohs(port));
+}
+
+/******************************************************************
+  Function:     proc_flow_seq_show
+  Description:  iteration function, output a flow: MAC address,
+                protocol, local and remote address, upload and
+                download bytes, upload and download packets
+******************************************************************/
+static int proc_flow_seq_show(struct seq_file *m, void *v)
+{
+	struct dt_flow_record *rec = v;
+
+	dump_mac_addr(m, rec->mac_addr);
+	seq_printf(m, "%u\t", rec->protocol);
+	dump_flow_addr(m, rec, rec->local_addr, rec->local_port);
+	dump_flow_addr(m, rec, rec->remote_addr, rec->remote_port);
+	seq_printf(m, "%llu\t%llu\t%llu\t%llu\n",
+			(unsigned long long)rec->upload_bytes,
+			(unsigned long long)rec->download_bytes,
+			(unsigned long long)rec->upload_packets,
+			(unsigned long long)rec->download_packets);
+
+	return 0;
+}
+
+static const struct seq_operations proc_flow_seq_ops = {
+	.start = proc_flow_seq_start,
+	.next = proc_flow_seq_next,
+	.stop = proc_flow_seq_stop,
+	.show = proc_flow_seq_show,
+};
+
+int proc_flow_seq_open(struct inode *inode, struct file *filp)
+{
+	return seq_open_private(filp, &proc_flow_seq_ops, sizeof(struct dt_flow_record));
+}
+
+/******************************************************************
+  Function:     proc_class_seq_show
+  Description:  iteration function, output the bytes of each
+                traffic class of a host: MAC address, then
+                class:download:upload for each class in use
+******************************************************************/
+static int proc_class_seq_show(struct seq_file *m, void *v)
+{
+	struct list_head *temp = (struct list_head *)v;
+	struct host_entry *host =
+		list_entry(temp, struct host_entry, lru_tbl_node);
+	struct class_table *tbl = rcu_dereference(g_class_table);
+	u64 class_bytes[2][HOST_CLASS_NUM];
+	unsigned int num = tbl != NULL ? tbl->num : 1;
+	unsigned int i;
+
+	host_class_read(host, class_bytes);
+
+	dump_mac_addr(m, host->mac_addr);
+	for (i = 0; i < num; i++) {
+		if (tbl != NULL && tbl->name[i][0] == '\0')
+			continue;
+		seq_printf(m, "%s%s:%llu:%llu", i == 0 ? "" : "\t",
+				tbl != NULL ? tbl->name[i] : CLASS_OTHER_NAME,
+				(unsigned long long)class_bytes[INBOUND][i],
+				(unsigned long long)class_bytes[OUTBOUND][i]);
+	}
+	seq_putc(m, '\n');
+
+	return 0;
+}
+
+static const struct seq_operations proc_class_seq_ops = {
+	.start = proc_seq_start,
+	.next = proc_seq_next,
+	.stop = proc_seq_stop,
+	.show = proc_class_seq_show,
+};
+
+int proc_class_seq_open(struct inode *inode, struct file *filp)
+{
+	return seq_open(filp, &proc_class_seq_ops);
+}
+
+/******************************************************************
+  Function:     proc_rules_dup
+  Description:  copy the rules written to a proc file
+  Input:        buf, count, what is written
+  Return:       NUL terminated copy to kfree, or ERR_PTR
+******************************************************************/
+static char *proc_rules_dup(const char __user *buf, size_t count)
+{
+	char *rules = NULL;
+
+	if (count >= PROC_RULES_MAX_LEN)
+		return ERR_PTR(-EINVAL);
+
+	rules = kmalloc(count + 1, GFP_KERNEL);
+	if (rules == NULL)
+		return ERR_PTR(-ENOMEM);
+
+	if (copy_from_user(rules, buf, count)) {
+		kfree(rules);
+		return ERR_PTR(-EFAULT);
+	}
+	rules[count] = '\0';
+
+	return rules;
+}
+
+/******************************************************************
+  Function:     proc_class_write
+  Description:  replace the traffic class rules, one rule per
+                line: "<class> <tcp|udp|any> <ports>", ports
+                being a comma separated list of <port>[-<port>]
+  Return:       count in case of success, error code otherwise
+******************************************************************/
+ssize_t proc_class_write(struct file *filp, const char __user *buf,
+						size_t count, loff_t *ppos)
+{
+	char *rules = proc_rules_dup(buf, count);
+	int ret;
+
+	if (IS_ERR(rules))
+		return PTR_ERR(rules);
+
+	ret = class_rules_load(rules);
+	kfree(rules);
+
+	return ret < 0 ? ret : count;
+}
+
+/*************************************************************
+  Function:     proc_top_show
+  Description:  output the top talkers of the sketch: MAC
+                address, estimated bytes since the last reset,
+                and 1 if the host has an entry, 0 otherwise
+*************************************************************/
+static int proc_top_show(struct seq_file *m, void *v)
+{
+	struct sketch_candidate top[SKETCH_TOPN];
+	unsigned char mac_addr[ETH_ALEN];
+	int tracked;
+	int num, i;
+
+	num = sketch_top(top, SKETCH_TOPN);
+	if (num < 0)
+		return num;
+
+	for (i = 0; i < num; i++) {
+		key_to_mac(top[i].mac_key, mac_addr);
+
+		rcu_read_lock();
+		tracked = hlist_find_host_by_mac(mac_addr) != NULL;
+		rcu_read_unlock();
+
+		dump_mac_addr(m, mac_addr);
+		seq_printf(m, "%llu\t%d\n", (unsigned long long)top[i].bytes, tracked);
+	}
+
+	return 0;
+}
+
+int proc_top_open(struct inode *inode, struct file *filp)
+{
+	return single_open(filp, proc_top_show, NULL);
+}
+
+/*************************************************************
+  Function:     proc_port_show
+  Description:  output the aggregate of each bridge port and
+                each VLAN: kind, ifindex and name of the port
+                or VLAN ID, download/upload bytes and packets.
+                "other" is the traffic counted in no slot. The
+                packets which can't be put down to a host are
+                not counted, see data_traffic_port.c.
+*************************************************************/
+static int proc_port_show(struct seq_file *m, void *v)
+{
+	static const char *const kind_names[PORT_KIND_NUM] = { "port", "vlan" };
+	int n = 2 * max(PORT_SLOTS, VLAN_SLOTS) + 1;
+	struct port_counter *sum = NULL;
+	struct net_device *dev = NULL;
+	int kind, num, i;
+
+	sum = kmalloc(n * sizeof(*sum), GFP_KERNEL);
+	if (sum == NULL)
+		return -ENOMEM;
+
+	for (kind = 0; kind < PORT_KIND_NUM; kind++) {
+		num = port_table_read(kind, sum, n);
+
+		rcu_read_lock();
+		for (i = 0; i < num; i++) {
+			seq_printf(m, "%s\t", kind_names[kind]);
+			if (sum[i].key == PORT_KEY_OTHER) {
+				seq_printf(m, "other\t-\t");
+			} else if (kind == PORT_KIND_PORT) {
+				dev = dev_get_by_index_rcu(&init_net, sum[i].key);
+				seq_printf(m, "%d\t%s\t", sum[i].key, dev != NULL ? dev->name : "-");
+			} else {
+				seq_printf(m, "%d\t-\t", sum[i].key - 1);
+			}
+			seq_printf(m, "%llu\t%llu\t%llu\t%llu\n",
+				(unsigned long long)sum[i].bytes[INBOUND],
+				(unsigned long long)sum[i].bytes[OUTBOUND],
+				(unsigned long long)sum[i].packets[INBOUND],
+				(unsigned long long)sum[i].packets[OUTBOUND]);
+		}
+		rcu_read_unlock();
+	}
+
+	kfree(sum);
+
+	return 0;
+}
+
+int proc_port_open(struct inode *inode, struct file *filp)
+{
+	return single_open(filp, proc_port_show, NULL);
+}
+
+/* any write resets the sketch */
+ssize_t proc_top_write(struct file *filp, const char __user *buf,
+						size_t count, loff_t *ppos)
+{
+	sketch_reset();
+
+	return count;
+}
+
+/*************************************************************
+  Function:     proc_police_show
+  Description:  output the policer rules: MAC address, download
+                and upload rate in bytes per second, burst
+*************************************************************/
+static int proc_police_show(struct seq_file *m, void *v)
+{
+	struct police_rule *rule = NULL;
+	unsigned char mac_addr[ETH_ALEN];
+
+	rcu_read_lock();
+	list_for_each_entry_rcu(rule, &g_police_rules, list) {
+		key_to_mac(rule->mac_key, mac_addr);
+		dump_mac_addr(m, mac_addr);
+		seq_printf(m, "%u\t%u\t%u\n", rule->rate[INBOUND],
+				rule->rate[OUTBOUND], rule->burst);
+	}
+	rcu_read_unlock();
+
+	return 0;
+}
+
+int proc_police_open(struct inode *inode, struct file *filp)
+{
+	return single_open(filp, proc_police_show, NULL);
+}
+
+/******************************************************************
+  Function:     proc_police_write
+  Description:  set the policer rules, one MAC per line:
+                "<MAC> <download> <upload> [burst]", rates in
+                bytes per second, "0 0" removes the rule
+  Return:       count in case of success, error code otherwise
+******************************************************************/
+ssize_t proc_police_write(struct file *filp, const char __user *buf,
+						size_t count, loff_t *ppos)
+{
+	char *rules = proc_rules_dup(buf, count);
+	int ret;
+
+	if (IS_ERR(rules))
+		return PTR_ERR(rules);
+
+	ret = police_rules_write(rules);
+	kfree(rules);
+
+	return ret < 0 ? ret : count;
+}
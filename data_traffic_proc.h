@@ -16,7 +16,29 @@
 #include "data_traffic_host_entry.h"
 
 #define PROC_FILE_NAME "statistics"
+#define PROC_HASH_FILE_NAME "statistics_hash"
+#define PROC_RATE_FILE_NAME "statistics_rate"
+#define PROC_FLOW_FILE_NAME "statistics_flow"
+#define PROC_CLASS_FILE_NAME "statistics_class"
+#define PROC_TOP_FILE_NAME "statistics_top"
+#define PROC_POLICE_FILE_NAME "statistics_police"
+#define PROC_PORT_FILE_NAME "statistics_port"
+/* longest rule file accepted at once */
+#define PROC_RULES_MAX_LEN 4096
 
 extern int proc_seq_open(struct inode *inode, struct file *filp);
+extern int proc_hash_open(struct inode *inode, struct file *filp);
+extern int proc_rate_seq_open(struct inode *inode, struct file *filp);
+extern int proc_flow_seq_open(struct inode *inode, struct file *filp);
+extern int proc_class_seq_open(struct inode *inode, struct file *filp);
+extern ssize_t proc_class_write(struct file *filp, const char __user *buf,
+						size_t count, loff_t *ppos);
+extern int proc_police_open(struct inode *inode, struct file *filp);
+extern ssize_t proc_police_write(struct file *filp, const char __user *buf,
+						size_t count, loff_t *ppos);
+extern int proc_port_open(struct inode *inode, struct file *filp);
+extern int proc_top_open(struct inode *inode, struct file *filp);
+extern ssize_t proc_top_write(struct file *filp, const char __user *buf,
+						size_t count, loff_t *ppos);
 
 #endif
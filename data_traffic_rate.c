@@ -0,0 +1,120 @@
+/*********************************************************
+* FILE NAME		:	data_traffic_rate.c
+* VERSION		:	1.0
+* DESCRIPTION	:	Rate estimator of a host, EWMA of bytes and
+*					packets per second over 1s, 10s and 60s.
+*
+*					The estimator is fed with the folded totals
+*					by the timer every second, readers only get
+*					the averages. The rate since the last update
+*					is weighted by elapsed / window, so a late
+*					timer tick doesn't bias the averages.
+*
+* CREATE DATE	:	17/10/2026
+*********************************************************/
+#include <linux/kernel.h>
+#include <linux/jiffies.h>
+#include <linux/math64.h>
+#include <linux/string.h>
+#include "data_traffic_rate.h"
+
+const unsigned int rate_window[RATE_WINDOW_NUM] = RATE_WINDOWS;
+
+/* rate between two totals, fixed point */
+static u64 rate_instant(u64 from, u64 to, unsigned long elapsed)
+{
+	return div64_u64((to - from) * HZ << RATE_SHIFT, elapsed);
+}
+
+/*************************************************************
+  Function:     rate_ewma
+  Description:  move the average towards the rate since last
+                update, weighted by elapsed time over window
+  Input:        avg, average to update, fixed point
+                rate, rate since last update, fixed point
+                elapsed, jiffies since last update
+                window, window length in jiffies
+*************************************************************/
+static void rate_ewma(u64 *avg, u64 rate, unsigned long elapsed, unsigned long window)
+{
+	if (elapsed >= window)
+		*avg = rate;
+	else if (rate >= *avg)
+		*avg += div64_u64((rate - *avg) * elapsed, window);
+	else
+		*avg -= div64_u64((*avg - rate) * elapsed, window);
+}
+
+/*************************************************************
+  Function:     rate_estimator_reset
+  Description:  restart the estimator from the given totals
+  Input:        est, estimator to reset
+                bytes, packets, totals by direction
+*************************************************************/
+void rate_estimator_reset(struct rate_estimator *est,
+						const u64 *bytes, const u64 *packets)
+{
+	memset(est, 0, sizeof(*est));
+	est->stamp = jiffies;
+	memcpy(est->bytes, bytes, sizeof(est->bytes));
+	memcpy(est->packets, packets, sizeof(est->packets));
+}
+
+/*************************************************************
+  Function:     rate_estimator_update
+  Description:  feed the estimator with the current totals, it
+                is updated once the last update is at least half
+                a second old, so that a late update doesn't make
+                the next one skip a second. The caller serializes
+                the updates.
+  Input:        est, estimator to update
+                bytes, packets, totals by direction
+*************************************************************/
+void rate_estimator_update(struct rate_estimator *est,
+						const u64 *bytes, const u64 *packets)
+{
+	unsigned long now = jiffies;
+	unsigned long elapsed = now - est->stamp;
+	u64 byte_rate, packet_rate;
+	int dir, w;
+
+	if (elapsed < HZ / 2)
+		return;
+
+	for (dir = 0; dir < RATE_DIR_NUM; dir++) {
+		byte_rate = rate_instant(est->bytes[dir], bytes[dir], elapsed);
+		packet_rate = rate_instant(est->packets[dir], packets[dir], elapsed);
+
+		for (w = 0; w < RATE_WINDOW_NUM; w++) {
+			rate_ewma(&est->avg_bytes[dir][w], byte_rate, elapsed, rate_window[w] * HZ);
+			rate_ewma(&est->avg_packets[dir][w], packet_rate, elapsed, rate_window[w] * HZ);
+		}
+
+		est->bytes[dir] = bytes[dir];
+		est->packets[dir] = packets[dir];
+	}
+
+	est->stamp = now;
+}
+
+/*************************************************************
+  Function:     rate_estimator_report
+  Description:  convert the averages to bytes and packets per
+                second
+  Input:        est, estimator to read
+                report, where to store the rates
+*************************************************************/
+void rate_estimator_report(const struct rate_estimator *est,
+						struct rate_report *report)
+{
+	int dir, w;
+
+	for (dir = 0; dir < RATE_DIR_NUM; dir++) {
+		for (w = 0; w < RATE_WINDOW_NUM; w++) {
+			report->bytes[dir][w] =
+				min_t(u64, est->avg_bytes[dir][w] >> RATE_SHIFT, UINT_MAX);
+			report->packets[dir][w] =
+				min_t(u64, est->avg_packets[dir][w] >> RATE_SHIFT, UINT_MAX);
+		}
+	}
+}
@@ -0,0 +1,50 @@
+/*********************************************************
+* FILE NAME		:	data_traffic_rate.h
+* VERSION		:	1.0
+* DESCRIPTION	:	Rate estimator of a host, EWMA of bytes and
+*					packets per second over 1s, 10s and 60s.
+*
+* CREATE DATE	:	17/10/2026
+*********************************************************/
+#ifndef _DATA_TRAFFIC_RATE_H
+#define _DATA_TRAFFIC_RATE_H
+
+#include <linux/types.h>
+
+#define RATE_WINDOW_NUM 3
+/* fixed point, rates are kept in 1/1024 per second */
+#define RATE_SHIFT 10
+/* direction, same as INBOUND and OUTBOUND */
+#define RATE_DIR_NUM 2
+
+/* window length in seconds, index of the averages */
+#define RATE_WINDOWS { 1, 10, 60 }
+
+/**
+ * estimator state, updated from counter snapshots by the timer every
+ * second, never on the packet path
+ */
+struct rate_estimator {
+	unsigned long stamp;
+	u64 bytes[RATE_DIR_NUM];
+	u64 packets[RATE_DIR_NUM];
+	u64 avg_bytes[RATE_DIR_NUM][RATE_WINDOW_NUM];
+	u64 avg_packets[RATE_DIR_NUM][RATE_WINDOW_NUM];
+};
+
+/* bytes and packets per second, by direction and window */
+struct rate_report {
+	unsigned int bytes[RATE_DIR_NUM][RATE_WINDOW_NUM];
+	unsigned int packets[RATE_DIR_NUM][RATE_WINDOW_NUM];
+};
+
+extern const unsigned int rate_window[RATE_WINDOW_NUM];
+
+extern void rate_estimator_reset(struct rate_estimator *est,
+						const u64 *bytes, const u64 *packets);
+extern void rate_estimator_update(struct rate_estimator *est,
+						const u64 *bytes, const u64 *packets);
+extern void rate_estimator_report(const struct rate_estimator *est,
+						struct rate_report *report);
+
+#endif
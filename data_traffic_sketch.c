@@ -0,0 +1,207 @@
+/*********************************************************
+* FILE NAME		:	data_traffic_sketch.c
+* VERSION		:	1.0
+* DESCRIPTION	:	Count-min sketch of bytes per MAC address,
+*					with space saving heavy hitter candidates.
+*
+*					Every CPU owns a sketch, so the packet path
+*					takes no lock. The estimate of a MAC is the
+*					sum over CPUs of the smallest of its counters,
+*					never below the real count. The candidates of
+*					a CPU are the MACs with the largest estimates
+*					it has seen. Readers merge the candidates of
+*					all the CPUs without walking the lru table.
+*
+* CREATE DATE	:	17/10/2026
+*********************************************************/
+#include <linux/kernel.h>
+#include <linux/percpu.h>
+#include <linux/cpumask.h>
+#include <linux/jhash.h>
+#include <linux/random.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/string.h>
+#include "data_traffic_sketch.h"
+
+static struct sketch __percpu *g_sketch;
+static u32 g_sketch_seed __read_mostly;
+/* bumped to reset all the sketches */
+static unsigned int g_sketch_epoch;
+
+/* the SKETCH_DEPTH counters of a MAC, by double hashing of one jhash */
+#define SKETCH_INDEX(hash, row) \
+	(((hash) + (row) * (((hash) >> 16) | 1)) & (SKETCH_WIDTH - 1))
+
+static inline u32 sketch_hash(u64 mac_key)
+{
+	return jhash_2words((u32)mac_key, (u32)(mac_key >> 32), g_sketch_seed);
+}
+
+/*************************************************************
+  Function:     sketch_account
+  Description:  add the bytes of a packet to the sketch of local
+                CPU and update its heavy hitter candidates
+  Input:        mac_key, MAC address of the host, see mac_to_key
+                len, bytes of the packet
+*************************************************************/
+void sketch_account(u64 mac_key, unsigned int len)
+{
+	struct sketch *sk = this_cpu_ptr(g_sketch);
+	struct sketch_candidate *min = &sk->top[0];
+	u32 hash = sketch_hash(mac_key);
+	u64 estimate = ~0ULL, bytes;
+	unsigned int epoch = ACCESS_ONCE(g_sketch_epoch);
+	int i;
+
+	if (unlikely(sk->epoch != epoch)) {
+		memset(sk, 0, sizeof(*sk));
+		sk->epoch = epoch;
+	}
+
+	for (i = 0; i < SKETCH_DEPTH; i++) {
+		bytes = sk->count[i][SKETCH_INDEX(hash, i)] += len;
+		if (bytes < estimate)
+			estimate = bytes;
+	}
+
+	/* space saving, a heavier MAC replaces the lightest candidate */
+	for (i = 0; i < SKETCH_TOPK; i++) {
+		if (sk->top[i].bytes != 0 && sk->top[i].mac_key == mac_key) {
+			sk->top[i].bytes = estimate;
+			return;
+		}
+		if (sk->top[i].bytes < min->bytes)
+			min = &sk->top[i];
+	}
+	if (estimate > min->bytes) {
+		min->mac_key = mac_key;
+		min->bytes = estimate;
+	}
+}
+
+/* reset the sketches, each CPU clears its own at its next packet */
+void sketch_reset(void)
+{
+	g_sketch_epoch++;
+}
+
+/*************************************************************
+  Function:     sketch_query
+  Description:  estimate the bytes of a MAC address. Counters
+                are read while being written, it's approximate.
+  Input:        mac_key, MAC address, see mac_to_key
+  Return:       estimated bytes since the last reset
+*************************************************************/
+u64 sketch_query(u64 mac_key)
+{
+	struct sketch *sk = NULL;
+	u32 hash = sketch_hash(mac_key);
+	unsigned int epoch = ACCESS_ONCE(g_sketch_epoch);
+	u64 total = 0, estimate, bytes;
+	int cpu, i;
+
+	for_each_possible_cpu(cpu) {
+		sk = per_cpu_ptr(g_sketch, cpu);
+		if (ACCESS_ONCE(sk->epoch) != epoch)
+			continue;
+
+		estimate = ~0ULL;
+		for (i = 0; i < SKETCH_DEPTH; i++) {
+			bytes = ACCESS_ONCE(sk->count[i][SKETCH_INDEX(hash, i)]);
+			if (bytes < estimate)
+				estimate = bytes;
+		}
+		total += estimate;
+	}
+
+	return total;
+}
+
+static int sketch_candidate_cmp(const void *a, const void *b)
+{
+	const struct sketch_candidate *x = a, *y = b;
+
+	if (x->bytes == y->bytes)
+		return 0;
+
+	return x->bytes < y->bytes ? 1 : -1;
+}
+
+/*************************************************************
+  Function:     sketch_top
+  Description:  merge the candidates of all the CPUs and get
+                the heaviest MAC addresses. Called in process
+                context.
+  Input:        top, to store at most n MACs, heaviest first
+                n, size of top
+  Return:       number of MACs stored, -ENOMEM if out of memory
+*************************************************************/
+int sketch_top(struct sketch_candidate *top, int n)
+{
+	struct sketch_candidate *all = NULL;
+	struct sketch *sk = NULL;
+	unsigned int epoch = ACCESS_ONCE(g_sketch_epoch);
+	u64 mac_key;
+	int num = 0;
+	int cpu, i, j;
+
+	all = kmalloc(num_possible_cpus() * SKETCH_TOPK * sizeof(*all), GFP_KERNEL);
+	if (all == NULL)
+		return -ENOMEM;
+
+	for_each_possible_cpu(cpu) {
+		sk = per_cpu_ptr(g_sketch, cpu);
+		if (ACCESS_ONCE(sk->epoch) != epoch)
+			continue;
+
+		for (i = 0; i < SKETCH_TOPK; i++) {
+			if (ACCESS_ONCE(sk->top[i].bytes) == 0)
+				continue;
+			mac_key = ACCESS_ONCE(sk->top[i].mac_key);
+
+			/* a MAC may be a candidate of several CPUs */
+			for (j = 0; j < num; j++) {
+				if (all[j].mac_key == mac_key)
+					break;
+			}
+			if (j < num)
+				continue;
+
+			all[num].mac_key = mac_key;
+			all[num].bytes = sketch_query(mac_key);
+			num++;
+		}
+	}
+
+	sort(all, num, sizeof(*all), sketch_candidate_cmp, NULL);
+	num = min(num, n);
+	memcpy(top, all, num * sizeof(*all));
+	kfree(all);
+
+	return num;
+}
+
+/*********************************************************
+  Function:     sketch_init
+  Description:  allocate the sketch of each CPU
+  Return:       return 0 in case of success,
+                return -ENOMEM if out of memory
+*********************************************************/
+int sketch_init(void)
+{
+	g_sketch = alloc_percpu(struct sketch);
+	if (g_sketch == NULL)
+		return -ENOMEM;
+
+	get_random_bytes(&g_sketch_seed, sizeof(g_sketch_seed));
+
+	return 0;
+}
+
+/* free the sketches, called once the hooks are unregistered */
+void sketch_exit(void)
+{
+	free_percpu(g_sketch);
+	g_sketch = NULL;
+}
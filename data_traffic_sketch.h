@@ -0,0 +1,49 @@
+/*********************************************************
+* FILE NAME		:	data_traffic_sketch.h
+* VERSION		:	1.0
+* DESCRIPTION	:	Approximate bytes per MAC address, counted
+*					for every packet of a known MAC before the
+*					host table, whether the host has an entry, a
+*					bridge port or is over its limit, to report
+*					the top talkers when there are more hosts than
+*					host entries.
+*
+* CREATE DATE	:	17/10/2026
+*********************************************************/
+#ifndef _DATA_TRAFFIC_SKETCH_H
+#define _DATA_TRAFFIC_SKETCH_H
+
+#include <linux/types.h>
+
+/* count-min sketch of each CPU, SKETCH_DEPTH rows of SKETCH_WIDTH counters */
+#define SKETCH_DEPTH 4
+#define SKETCH_WIDTH 512
+/* heavy hitter candidates of each CPU */
+#define SKETCH_TOPK 16
+/* top talkers reported */
+#define SKETCH_TOPN 16
+
+/* one heavy hitter candidate, bytes is its estimate */
+struct sketch_candidate {
+	u64 mac_key;
+	u64 bytes;
+};
+
+/**
+ * sketch of one CPU, only written by the owning CPU. It's cleared by
+ * its CPU when the global epoch moves on, readers skip stale sketches.
+ */
+struct sketch {
+	unsigned int epoch;
+	struct sketch_candidate top[SKETCH_TOPK];
+	u64 count[SKETCH_DEPTH][SKETCH_WIDTH];
+};
+
+extern int sketch_init(void);
+extern void sketch_exit(void);
+extern void sketch_account(u64 mac_key, unsigned int len);
+extern void sketch_reset(void);
+extern u64 sketch_query(u64 mac_key);
+extern int sketch_top(struct sketch_candidate *top, int n);
+
+#endif
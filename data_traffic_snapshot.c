@@ -0,0 +1,144 @@
+/*********************************************************
+* FILE NAME		:	data_traffic_snapshot.c
+* VERSION		:	1.0
+* DESCRIPTION	:	Double buffered binary snapshot of all the
+*					hosts, mapped into userspace through a proc
+*					file. The timer schedules a refresh every
+*					second, the inactive buffer is filled and
+*					then swapped in, so a collector reads all
+*					the hosts without any syscall.
+*
+* CREATE DATE	:	17/10/2026
+*********************************************************/
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/mm.h>
+#include <linux/vmalloc.h>
+#include <linux/rculist.h>
+#include <linux/workqueue.h>
+#include <linux/jiffies.h>
+#include "data_traffic_snapshot.h"
+#include "data_traffic_host_entry.h"
+
+static void *g_snapshot_area;
+static size_t g_snapshot_size;
+static struct dt_snapshot_header *g_snapshot_header;
+static struct dt_snapshot_buffer *g_snapshot_buffer[2];
+
+static void snapshot_refresh(struct work_struct *work);
+static DECLARE_WORK(g_snapshot_work, snapshot_refresh);
+
+/*************************************************************
+  Function:     snapshot_refresh
+  Description:  work function, write all the hosts into the
+                inactive buffer, then make it the active one
+*************************************************************/
+static void snapshot_refresh(struct work_struct *work)
+{
+	struct dt_snapshot_header *header = g_snapshot_header;
+	unsigned int next = !header->active;
+	struct dt_snapshot_buffer *buffer = g_snapshot_buffer[next];
+	struct host_entry *host = NULL;
+	unsigned int count = 0;
+
+	buffer->seq++;
+	smp_wmb();
+
+	rcu_read_lock();
+	list_for_each_entry_rcu(host, g_lru_table, lru_tbl_node) {
+		if (count == header->max_records)
+			break;
+		host_entry_to_record(host, &buffer->records[count++]);
+	}
+	rcu_read_unlock();
+
+	buffer->count = count;
+	buffer->timestamp_ms = jiffies_to_msecs(jiffies);
+
+	smp_wmb();
+	buffer->seq++;
+
+	header->active = next;
+	smp_wmb();
+	header->seq++;
+}
+
+/*********************************************
+  Function:     snapshot_schedule
+  Description:  refresh the snapshot, called
+                by the timer every second
+*********************************************/
+void snapshot_schedule(void)
+{
+	if (g_snapshot_area != NULL)
+		schedule_work(&g_snapshot_work);
+}
+
+/*************************************************************
+  Function:     snapshot_mmap
+  Description:  map header and both buffers read only into
+                userspace
+*************************************************************/
+static int snapshot_mmap(struct file *filp, struct vm_area_struct *vma)
+{
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+	if (vma->vm_pgoff != 0 || vma->vm_end - vma->vm_start > g_snapshot_size)
+		return -EINVAL;
+
+	vma->vm_flags &= ~VM_MAYWRITE;
+
+	return remap_vmalloc_range(vma, g_snapshot_area, 0);
+}
+
+const struct file_operations snapshot_proc_ops = {
+	.owner = THIS_MODULE,
+	.mmap = snapshot_mmap,
+};
+
+/*************************************************************
+  Function:     snapshot_init
+  Description:  allocate the header page and the two buffers,
+                sized for host_capacity hosts
+  Return:       return 0 in case of success,
+                return -ENOMEM if out of memory
+*************************************************************/
+int snapshot_init(void)
+{
+	size_t buffer_size = PAGE_ALIGN(sizeof(struct dt_snapshot_buffer) +
+						host_capacity * sizeof(struct dt_host_record));
+	size_t header_size = PAGE_ALIGN(sizeof(struct dt_snapshot_header));
+
+	g_snapshot_size = header_size + 2 * buffer_size;
+	g_snapshot_area = vmalloc_user(g_snapshot_size);
+	if (g_snapshot_area == NULL)
+		return -ENOMEM;
+
+	g_snapshot_header = g_snapshot_area;
+	g_snapshot_buffer[0] = g_snapshot_area + header_size;
+	g_snapshot_buffer[1] = g_snapshot_area + header_size + buffer_size;
+
+	g_snapshot_header->magic = DT_SNAPSHOT_MAGIC;
+	g_snapshot_header->version = DT_SNAPSHOT_VERSION;
+	g_snapshot_header->record_size = sizeof(struct dt_host_record);
+	g_snapshot_header->max_records = host_capacity;
+	g_snapshot_header->buffer_offset[0] = header_size;
+	g_snapshot_header->buffer_offset[1] = header_size + buffer_size;
+	g_snapshot_header->active = 0;
+	g_snapshot_header->seq = 0;
+
+	return 0;
+}
+
+/******************************************************
+  Function:     snapshot_exit
+  Description:  free the snapshot, the proc file must
+                have been removed
+******************************************************/
+void snapshot_exit(void)
+{
+	cancel_work_sync(&g_snapshot_work);
+
+	vfree(g_snapshot_area);
+	g_snapshot_area = NULL;
+}
@@ -0,0 +1,24 @@
+/*********************************************************
+* FILE NAME		:	data_traffic_snapshot.h
+* VERSION		:	1.0
+* DESCRIPTION	:	Double buffered binary snapshot of all the
+*					hosts, mapped into userspace through a proc
+*					file.
+*
+* CREATE DATE	:	17/10/2026
+*********************************************************/
+#ifndef _DATA_TRAFFIC_SNAPSHOT_H
+#define _DATA_TRAFFIC_SNAPSHOT_H
+
+#include <linux/fs.h>
+#include "data_traffic_export.h"
+
+#define PROC_SNAPSHOT_FILE_NAME "statistics_mmap"
+
+extern const struct file_operations snapshot_proc_ops;
+
+extern int snapshot_init(void);
+extern void snapshot_exit(void);
+extern void snapshot_schedule(void);
+
+#endif
@@ -0,0 +1,205 @@
+/*********************************************************
+* FILE NAME		:	data_traffic_stats.c
+* VERSION		:	1.0
+* DESCRIPTION	:	Per-CPU instrumentation counters, output
+*					through data_traffic/stats in debugfs, and
+*					the tracepoints of data_traffic_trace.h.
+*
+* CREATE DATE	:	17/10/2026
+*********************************************************/
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/percpu.h>
+#include <linux/cpumask.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/err.h>
+#include <linux/slab.h>
+#include <linux/ratelimit.h>
+#include "data_traffic_stats.h"
+
+#define CREATE_TRACE_POINTS
+#include "data_traffic_trace.h"
+
+#define DT_STATS_DIR_NAME "data_traffic"
+#define DT_STATS_FILE_NAME "stats"
+
+DEFINE_PER_CPU(struct dt_stats, g_dt_stats);
+
+static struct dentry *g_dt_stats_dir;
+
+static const char *const dt_stat_names[DT_STAT_NUM] = {
+	[DT_STAT_NEIGH_HIT] = "neigh_cache_hit",
+	[DT_STAT_NEIGH_MISS] = "neigh_cache_miss",
+	[DT_STAT_BATCH_HIT] = "batch_hit",
+	[DT_STAT_BATCH_MISS] = "batch_miss",
+	[DT_STAT_HOST_ADD] = "host_add",
+	[DT_STAT_EVICT] = "evict",
+	[DT_STAT_EXPIRE] = "expire",
+};
+
+static const char *const dt_error_names[DT_ERR_NUM] = {
+	[DT_ERR_NO_NEIGH] = "error_no_neigh",
+	[DT_ERR_ZERO_MAC] = "error_zero_mac",
+	[DT_ERR_NO_PORT] = "error_no_port",
+	[DT_ERR_POOL_EXHAUSTED] = "error_pool_exhausted",
+	[DT_ERR_NO_SPARE] = "error_no_spare",
+};
+
+/* what is logged for each error, at most once per interval */
+static const char *const dt_error_messages[DT_ERR_NUM] = {
+	[DT_ERR_NO_NEIGH] = "Cannot find host according to IP",
+	[DT_ERR_ZERO_MAC] = "Neighbour with zero MAC address, packet dropped",
+	[DT_ERR_NO_PORT] = "Cannot find bridge port of host",
+	[DT_ERR_POOL_EXHAUSTED] = "No free host entry, host not recorded",
+	[DT_ERR_NO_SPARE] = "Host entries being allocated, host not recorded yet",
+};
+
+/* statically initialised, the hooks may report before dt_stats_init */
+static DEFINE_RATELIMIT_STATE(dt_ratelimit_no_neigh, 5 * HZ, 1);
+static DEFINE_RATELIMIT_STATE(dt_ratelimit_zero_mac, 5 * HZ, 1);
+static DEFINE_RATELIMIT_STATE(dt_ratelimit_no_port, 5 * HZ, 1);
+static DEFINE_RATELIMIT_STATE(dt_ratelimit_pool_exhausted, 5 * HZ, 1);
+static DEFINE_RATELIMIT_STATE(dt_ratelimit_no_spare, 5 * HZ, 1);
+
+static struct ratelimit_state *const dt_error_ratelimit[DT_ERR_NUM] = {
+	[DT_ERR_NO_NEIGH] = &dt_ratelimit_no_neigh,
+	[DT_ERR_ZERO_MAC] = &dt_ratelimit_zero_mac,
+	[DT_ERR_NO_PORT] = &dt_ratelimit_no_port,
+	[DT_ERR_POOL_EXHAUSTED] = &dt_ratelimit_pool_exhausted,
+	[DT_ERR_NO_SPARE] = &dt_ratelimit_no_spare,
+};
+
+/*************************************************************
+  Function:     dt_error
+  Description:  count an error of the packet path on local CPU,
+                log it at most once per 5 seconds for a reason,
+                so that a burst never floods the console
+  Input:        reason, why the packet could not be accounted
+*************************************************************/
+void dt_error(enum dt_error reason)
+{
+	this_cpu_inc(g_dt_stats.error[reason]);
+
+	if (__ratelimit(dt_error_ratelimit[reason]))
+		printk(KERN_WARNING "data_traffic: %s.\n", dt_error_messages[reason]);
+}
+
+/*************************************************************
+  Function:     dt_stats_fold
+  Description:  sum the counters of all the CPUs
+  Input:        sum, to store the sum
+*************************************************************/
+static void dt_stats_fold(struct dt_stats *sum)
+{
+	struct dt_stats *stats = NULL;
+	int cpu, i;
+
+	memset(sum, 0, sizeof(*sum));
+
+	for_each_possible_cpu(cpu) {
+		stats = per_cpu_ptr(&g_dt_stats, cpu);
+		for (i = 0; i < DT_STAT_NUM; i++)
+			sum->item[i] += ACCESS_ONCE(stats->item[i]);
+		for (i = 0; i < DT_ERR_NUM; i++)
+			sum->error[i] += ACCESS_ONCE(stats->error[i]);
+		for (i = 0; i < DT_CYCLES_BUCKETS; i++) {
+			sum->hook_cycles[i] += ACCESS_ONCE(stats->hook_cycles[i]);
+			sum->sweep_cycles[i] += ACCESS_ONCE(stats->sweep_cycles[i]);
+		}
+		for (i = 0; i < HASH_HISTOGRAM_SIZE; i++)
+			sum->chain[i] += ACCESS_ONCE(stats->chain[i]);
+	}
+}
+
+/* output the log2 buckets in use, bucket n counts [2^(n-1), 2^n) */
+static void dt_stats_show_hist(struct seq_file *m, const char *name, u64 *hist)
+{
+	int i;
+
+	for (i = 0; i < DT_CYCLES_BUCKETS; i++) {
+		if (hist[i] == 0)
+			continue;
+		if (i == DT_CYCLES_BUCKETS - 1)
+			seq_printf(m, "%s_%llu+\t%llu\n", name,
+					1ULL << (i - 1), (unsigned long long)hist[i]);
+		else
+			seq_printf(m, "%s_%llu\t%llu\n", name,
+					i == 0 ? 0 : 1ULL << (i - 1), (unsigned long long)hist[i]);
+	}
+}
+
+/*************************************************************
+  Function:     dt_stats_show
+  Description:  output the counters, the histogram of cycles per
+                packet in the hook, hash chain walked per lookup
+                and cycles per timer sweep
+*************************************************************/
+static int dt_stats_show(struct seq_file *m, void *v)
+{
+	struct dt_stats *sum = NULL;
+	int i;
+
+	sum = kmalloc(sizeof(*sum), GFP_KERNEL);
+	if (sum == NULL)
+		return -ENOMEM;
+
+	dt_stats_fold(sum);
+
+	for (i = 0; i < DT_STAT_NUM; i++)
+		seq_printf(m, "%s\t%llu\n", dt_stat_names[i], (unsigned long long)sum->item[i]);
+	for (i = 0; i < DT_ERR_NUM; i++)
+		seq_printf(m, "%s\t%llu\n", dt_error_names[i], (unsigned long long)sum->error[i]);
+	dt_stats_show_hist(m, "hook_cycles", sum->hook_cycles);
+	for (i = 0; i < HASH_HISTOGRAM_SIZE - 1; i++)
+		seq_printf(m, "lookup_chain_%d\t%llu\n", i, (unsigned long long)sum->chain[i]);
+	seq_printf(m, "lookup_chain_%d+\t%llu\n", i, (unsigned long long)sum->chain[i]);
+	dt_stats_show_hist(m, "sweep_cycles", sum->sweep_cycles);
+
+	kfree(sum);
+
+	return 0;
+}
+
+static int dt_stats_open(struct inode *inode, struct file *filp)
+{
+	return single_open(filp, dt_stats_show, NULL);
+}
+
+static const struct file_operations dt_stats_ops = {
+	.owner = THIS_MODULE,
+	.open = dt_stats_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+/*********************************************************
+  Function:     dt_stats_init
+  Description:  create the debugfs file of the counters
+  Return:       return 0 in case of success,
+                return -ENODEV without debugfs,
+                return -ENOMEM if out of memory
+*********************************************************/
+int dt_stats_init(void)
+{
+	struct dentry *dir = NULL;
+
+	dir = debugfs_create_dir(DT_STATS_DIR_NAME, NULL);
+	if (IS_ERR_OR_NULL(dir))
+		return dir == NULL ? -ENOMEM : PTR_ERR(dir);
+
+	if (debugfs_create_file(DT_STATS_FILE_NAME, 0444, dir, NULL, &dt_stats_ops) == NULL) {
+		debugfs_remove_recursive(dir);
+		return -ENOMEM;
+	}
+	g_dt_stats_dir = dir;
+
+	return 0;
+}
+
+void dt_stats_exit(void)
+{
+	debugfs_remove_recursive(g_dt_stats_dir);
+	g_dt_stats_dir = NULL;
+}
@@ -0,0 +1,90 @@
+/*********************************************************
+* FILE NAME		:	data_traffic_stats.h
+* VERSION		:	1.0
+* DESCRIPTION	:	Per-CPU instrumentation counters of the
+*					packet path, host table and timer, merged
+*					and output through debugfs.
+*
+* CREATE DATE	:	17/10/2026
+*********************************************************/
+#ifndef _DATA_TRAFFIC_STATS_H
+#define _DATA_TRAFFIC_STATS_H
+
+#include <linux/types.h>
+#include <linux/percpu.h>
+#include <linux/log2.h>
+#include <linux/timex.h>
+#include "data_traffic_host_entry.h"
+
+/* log2 histogram of cycles, the last bucket counts everything above */
+#define DT_CYCLES_BUCKETS 32
+
+enum dt_stat_item {
+	DT_STAT_NEIGH_HIT,
+	DT_STAT_NEIGH_MISS,
+	DT_STAT_BATCH_HIT,
+	DT_STAT_BATCH_MISS,
+	DT_STAT_HOST_ADD,
+	DT_STAT_EVICT,
+	DT_STAT_EXPIRE,
+	DT_STAT_NUM,
+};
+
+/* why a packet could not be accounted */
+enum dt_error {
+	DT_ERR_NO_NEIGH,
+	DT_ERR_ZERO_MAC,
+	DT_ERR_NO_PORT,
+	DT_ERR_POOL_EXHAUSTED,
+	DT_ERR_NO_SPARE,
+	DT_ERR_NUM,
+};
+
+/* counters of one CPU, only written by this CPU, read without sync */
+struct dt_stats {
+	u64 item[DT_STAT_NUM];
+	u64 error[DT_ERR_NUM];
+	u64 hook_cycles[DT_CYCLES_BUCKETS];
+	u64 chain[HASH_HISTOGRAM_SIZE];
+	u64 sweep_cycles[DT_CYCLES_BUCKETS];
+};
+
+DECLARE_PER_CPU(struct dt_stats, g_dt_stats);
+
+static inline unsigned int dt_cycles_bucket(u64 cycles)
+{
+	unsigned int bucket = cycles == 0 ? 0 : ilog2(cycles) + 1;
+
+	return min_t(unsigned int, bucket, DT_CYCLES_BUCKETS - 1);
+}
+
+static inline void dt_stat_inc(enum dt_stat_item item)
+{
+	this_cpu_inc(g_dt_stats.item[item]);
+}
+
+static inline void dt_stat_add(enum dt_stat_item item, unsigned int n)
+{
+	this_cpu_add(g_dt_stats.item[item], n);
+}
+
+static inline void dt_stat_chain(unsigned int len)
+{
+	this_cpu_inc(g_dt_stats.chain[min_t(unsigned int, len, HASH_HISTOGRAM_SIZE - 1)]);
+}
+
+static inline void dt_stat_hook_cycles(u64 cycles)
+{
+	this_cpu_inc(g_dt_stats.hook_cycles[dt_cycles_bucket(cycles)]);
+}
+
+static inline void dt_stat_sweep_cycles(u64 cycles)
+{
+	this_cpu_inc(g_dt_stats.sweep_cycles[dt_cycles_bucket(cycles)]);
+}
+
+extern void dt_error(enum dt_error reason);
+extern int dt_stats_init(void);
+extern void dt_stats_exit(void);
+
+#endif
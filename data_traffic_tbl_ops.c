@@ -2,125 +2,519 @@
  * FILE NAME		:	data_traffic_tbl_ops.c
  * VERSION			:	1.0
  * DESCRIPTION		:	Operations on hash table, lru table and
- *						free table
+ *						host entry magazines
  *
  * AUTHOR			:	tangyupeng
  * CREATE DATE		:	11/10/2016
  *****************************************************/
 #include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/moduleparam.h>
+#include <linux/percpu.h>
 #include <linux/string.h>
 #include <linux/list.h>
+#include <linux/rculist.h>
+#include <linux/rcupdate.h>
 #include <linux/if_ether.h>
 #include <linux/spinlock.h>
+#include <linux/mutex.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/mm.h>
+#include <linux/log2.h>
+#include <linux/workqueue.h>
+#include <linux/jhash.h>
+#include <linux/random.h>
+#include <linux/topology.h>
+#include <linux/netdevice.h>
+#include <net/net_namespace.h>
+#include <linux/ratelimit.h>
+#include <linux/jiffies.h>
 #include "data_traffic_tbl_ops.h"
 #include "data_traffic_host_entry.h"
+#include "data_traffic_neigh_cache.h"
+#include "data_traffic_stats.h"
+#include "data_traffic_trace.h"
 
-#define HASH_FUNC(mac_addr) (*(mac_addr + 4) ^ *(mac_addr + 5)) & (MAX_HOST_NUM - 1)
+#define HASH_FUNC(key, size) (jhash_2words((u32)(key), (u32)((key) >> 32), g_hash_seed) & ((size) - 1))
+
+/* random per boot, so that the bucket of a MAC can't be predicted */
+static u32 g_hash_seed __read_mostly;
+
+/**
+ * Serialize all the writers of hash table and lru table.
+ * Readers walk hash table and lru table under rcu_read_lock() only.
+ */
+static DEFINE_SPINLOCK(g_tbl_lock);
+
+/* bumped on every host removal, see struct host_batch */
+static atomic_t g_host_remove_gen = ATOMIC_INIT(0);
+
+/**
+ * The host of the last packet seen by each CPU. It's only trusted while
+ * g_host_remove_gen is the same as when it was recorded.
+ */
+struct host_batch {
+	u64 mac_key;
+	unsigned int gen;
+	struct host_entry *host;
+};
+static DEFINE_PER_CPU(struct host_batch, g_host_batch);
+
+static bool batch_accounting = true;
+module_param(batch_accounting, bool, 0644);
+MODULE_PARM_DESC(batch_accounting, "skip the hash lookup for back to back packets of a host");
+
+/**
+ * Expiry wheel, one slot per second. A host is queued in the slot of the
+ * second it may expire in, the timer only looks at the slot of the
+ * current second. The wheel is longer than HOST_EXPIRE_TIME, so all the
+ * entries of a slot are due when it's processed.
+ */
+#define EXPIRY_WHEEL_SIZE (HOST_EXPIRE_TIME + 2)
+static struct list_head g_expiry_wheel[EXPIRY_WHEEL_SIZE];
+/* seconds since the module is loaded, advanced by the timer */
+static unsigned int g_expiry_clock;
+
+/**
+ * Ring of the last removed hosts, so that a delta dump can report them.
+ * Written with g_tbl_lock held, gen is the low 32 bits of jiffies at the
+ * removal, the clock of the netlink generations.
+ */
+struct host_tombstone {
+	u64 mac_key;
+	u32 gen;
+};
+static struct host_tombstone g_tombstones[HOST_TOMBSTONE_NUM];
+/* number of hosts removed since the module is loaded */
+static unsigned long g_tombstone_count;
+/* gen of the last tombstone overwritten in the ring */
+static u32 g_tombstone_lost_gen;
+
+/* next lru table entry to check for CLOCK eviction, NULL for the first */
+static struct list_head *g_clock_hand;
+
+static void hash_table_resize(struct work_struct *work);
+static DECLARE_WORK(g_hash_resize_work, hash_table_resize);
+/* serializes the replacements of the hash table */
+static DEFINE_MUTEX(g_hash_resize_mutex);
+
+/* get the host entry from its node of the given hash table generation */
+static inline struct host_entry *hash_node_to_host(struct hlist_node *n, unsigned int node)
+{
+	return container_of(n - node, struct host_entry, hash_tbl_node[0]);
+}
+
+/*************************************************************
+  Function:     alloc_hash_table
+  Description:  allocate an empty hash table
+  Input:        size, number of buckets, must be power of 2
+                node, which hash_tbl_node of host entry links
+                      this table
+  Return:       the hash table, NULL if out of memory
+*************************************************************/
+static struct host_hash_table *alloc_hash_table(unsigned int size, unsigned int node)
+{
+	struct host_hash_table *tbl = NULL;
+	size_t len = sizeof(*tbl) + size * sizeof(struct hlist_head);
+	unsigned int i;
+
+	if (len > PAGE_SIZE)
+		tbl = vzalloc(len);
+	else
+		tbl = kzalloc(len, GFP_KERNEL);
+	if (tbl == NULL)
+		return NULL;
+
+	tbl->size = size;
+	tbl->node = node;
+	for (i = 0; i < size; i++)
+		INIT_HLIST_HEAD(&tbl->buckets[i]);
+
+	return tbl;
+}
+
+static void free_hash_table(struct host_hash_table *tbl)
+{
+	if (tbl == NULL)
+		return;
+
+	if (is_vmalloc_addr(tbl))
+		vfree(tbl);
+	else
+		kfree(tbl);
+}
+
+/*************************************************************
+  Function:     hash_table_grow
+  Description:  double the hash table until it has a bucket per
+                host, for the hosts recorded or count hosts if
+                more. Entries are linked into the new table
+                through their other hash node, so lock-free
+                lookups keep using the old table until the new
+                one is published. The old table is freed after
+                a grace period. Called in process context.
+  Input:        count, number of hosts to size the table for
+*************************************************************/
+static void hash_table_grow(unsigned int count)
+{
+	struct host_hash_table *old_tbl = NULL;
+	struct host_hash_table *new_tbl = NULL;
+	unsigned int max_size = roundup_pow_of_two(host_capacity);
+	unsigned int size;
+	struct host_entry *host = NULL;
+
+	mutex_lock(&g_hash_resize_mutex);
+	old_tbl = rcu_dereference_protected(g_hash_table,
+				lockdep_is_held(&g_hash_resize_mutex));
+	size = old_tbl->size;
+
+	count = max(count, ACCESS_ONCE(g_host_count));
+	while (size < count && size < max_size)
+		size <<= 1;
+	if (size == old_tbl->size)
+		goto unlock;
+
+	new_tbl = alloc_hash_table(size, !old_tbl->node);
+	if (new_tbl == NULL) {
+		printk(KERN_ERR "Alloc hash table of %u buckets failed.\n", size);
+		goto unlock;
+	}
+
+	spin_lock_bh(&g_tbl_lock);
+	/* all the hashed entries are in lru table */
+	list_for_each_entry(host, g_lru_table, lru_tbl_node)
+		hlist_add_head_rcu(&host->hash_tbl_node[new_tbl->node],
+				&new_tbl->buckets[HASH_FUNC(host->mac_key, size)]);
+	rcu_assign_pointer(g_hash_table, new_tbl);
+	spin_unlock_bh(&g_tbl_lock);
+
+	synchronize_rcu();
+	free_hash_table(old_tbl);
+
+unlock:
+	mutex_unlock(&g_hash_resize_mutex);
+}
+
+/* work function, grow the hash table for the hosts recorded */
+static void hash_table_resize(struct work_struct *work)
+{
+	hash_table_grow(0);
+}
+
+/**********************************************************
+  Function:     init_hash_table
+  Description:  pick the hash seed of this module load and
+                allocate the smallest hash table
+  Return:       return 0 in case of success,
+                return -ENOMEM if out of memory
+**********************************************************/
+int init_hash_table(void)
+{
+	struct host_hash_table *tbl = NULL;
+
+	get_random_bytes(&g_hash_seed, sizeof(g_hash_seed));
+
+	tbl = alloc_hash_table(HASH_TABLE_MIN_SIZE, 0);
+	if (tbl == NULL)
+		return -ENOMEM;
+
+	RCU_INIT_POINTER(g_hash_table, tbl);
+
+	return 0;
+}
+
+/*********************************************
+  Function:     destroy_hash_table
+  Description:  wait for the pending resizing
+                and free the hash table
+*********************************************/
+void destroy_hash_table(void)
+{
+	cancel_work_sync(&g_hash_resize_work);
+
+	free_hash_table(rcu_dereference_protected(g_hash_table, 1));
+	RCU_INIT_POINTER(g_hash_table, NULL);
+}
 
 /********************************************************
   Function:     hlist_find_host_by_mac
   Description:  find host in hash table according to
-                MAC address
+                MAC address, must be called under
+                rcu_read_lock() or with g_tbl_lock held
   Input:        mac_addr, MAC address of the host to find
 ********************************************************/
-struct hlist_node *hlist_find_host_by_mac(unsigned char *mac_addr)
+struct host_entry *hlist_find_host_by_mac(unsigned char *mac_addr)
 {
-	struct hlist_node *temp = g_hash_table[HASH_FUNC(mac_addr)].first;
-	unsigned char *saved_mac_addr;
-	struct host_entry *host;
+	struct host_hash_table *tbl = NULL;
+	struct hlist_node *n = NULL;
+	struct host_entry *host = NULL;
+	unsigned int chain = 0;
+	u64 key;
 
 	if (mac_addr == NULL)
 		return NULL;
 
-	while (temp != NULL) {
-		host = hlist_entry(temp, struct host_entry, hash_tbl_node);
-		saved_mac_addr = host->info.mac_addr;
-		if (strncmp(saved_mac_addr, mac_addr, ETH_ALEN) == 0) {
-			return temp;
+	key = mac_to_key(mac_addr);
+	tbl = rcu_dereference_check(g_hash_table, lockdep_is_held(&g_tbl_lock));
+	n = rcu_dereference_check(hlist_first_rcu(&tbl->buckets[HASH_FUNC(key, tbl->size)]),
+				lockdep_is_held(&g_tbl_lock));
+	while (n != NULL) {
+		chain++;
+		host = hash_node_to_host(n, tbl->node);
+		if (host->mac_key == key) {
+			dt_stat_chain(chain);
+			return host;
 		}
-		temp = temp->next;
+		n = rcu_dereference_check(hlist_next_rcu(n), lockdep_is_held(&g_tbl_lock));
 	}
+	dt_stat_chain(chain);
 
 	return NULL;
 }
 
 /***************************************************
   Function:     hlist_add
-  Description:  add a new host entry to hash table
-  Input:        mac_address, MAC address of the host
-                n, host entry hash table head
+  Description:  add a new host entry to hash table,
+                called with g_tbl_lock held
+  Input:        host, host entry to add
 ***************************************************/
-static void hlist_add(unsigned char *mac_addr, struct hlist_node *n)
+static void hlist_add(struct host_entry *host)
 {
-	struct hlist_head *head = &g_hash_table[HASH_FUNC(mac_addr)];
+	struct host_hash_table *tbl =
+		rcu_dereference_protected(g_hash_table, lockdep_is_held(&g_tbl_lock));
+	struct hlist_head *head = &tbl->buckets[HASH_FUNC(host->mac_key, tbl->size)];
 
-	hlist_add_head(n, head);
+	hlist_add_head_rcu(&host->hash_tbl_node[tbl->node], head);
 }
 
-static void hlist_delete(struct hlist_node *n)
+static void hlist_delete(struct host_entry *host)
 {
-	hlist_del(n);
+	struct host_hash_table *tbl =
+		rcu_dereference_protected(g_hash_table, lockdep_is_held(&g_tbl_lock));
+
+	hlist_del_rcu(&host->hash_tbl_node[tbl->node]);
 }
 
-/**************************************************
-  Function:     list_del_last
-  Description:  Get the last entry of the specified
-                list and delte this entry
-  Input:        which table(list) to delete from
-**************************************************/
-static struct list_head *list_del_last(struct list_head *head)
+/**************************************************************
+  Function:     free_host_entry_rcu
+  Description:  RCU callback, put the host entry back in the
+                magazine of this CPU after all the readers
+                have left it
+**************************************************************/
+static void free_host_entry_rcu(struct rcu_head *head)
 {
-	struct list_head *temp = NULL;
+	struct host_entry *host = container_of(head, struct host_entry, rcu);
 
-	if (head->prev == head)
-		return NULL;
-	else {
-		temp = head->prev;
-		list_del(head->prev);
+	host_entry_put(host);
+}
 
-		return temp;
-	}
+/* record the removal of a host, called with g_tbl_lock held */
+static void host_tombstone_add(struct host_entry *host)
+{
+	struct host_tombstone *ts = &g_tombstones[g_tombstone_count % HOST_TOMBSTONE_NUM];
+
+	if (g_tombstone_count >= HOST_TOMBSTONE_NUM)
+		g_tombstone_lost_gen = ts->gen;
+	ts->mac_key = host->mac_key;
+	ts->gen = (u32)jiffies;
+	g_tombstone_count++;
 }
 
-/***************************************************
-  Function:     list_add_first
-  Description:  add a new entry right after head
-  Input:        new, list head to insert
-                head, to which table(list) to insert
-***************************************************/
-static struct list_head *list_add_first(struct list_head *new,
-									struct list_head *head)
+/*************************************************************
+  Function:     host_tombstones_read
+  Description:  get the MAC keys of the hosts removed since a
+                generation, oldest first
+  Input:        since, generation of the last delta dump
+                keys, to store at most max MAC keys
+                max, size of keys
+  Return:       number of MAC keys stored, -ERANGE if some of
+                the removals since that generation have been
+                overwritten in the ring
+*************************************************************/
+int host_tombstones_read(u32 since, u64 *keys, unsigned int max)
 {
-	if (new == NULL)
-		return NULL;
-	else {
-		list_add(new, head);
-		return new;
+	struct host_tombstone *ts = NULL;
+	unsigned long i;
+	int num = 0;
+
+	spin_lock_bh(&g_tbl_lock);
+
+	if (g_tombstone_count > HOST_TOMBSTONE_NUM &&
+		(s32)(g_tombstone_lost_gen - since) >= 0) {
+		num = -ERANGE;
+		goto unlock;
+	}
+
+	i = g_tombstone_count > HOST_TOMBSTONE_NUM ? g_tombstone_count - HOST_TOMBSTONE_NUM : 0;
+	for (; i < g_tombstone_count && num < max; i++) {
+		ts = &g_tombstones[i % HOST_TOMBSTONE_NUM];
+		if ((s32)(ts->gen - since) >= 0)
+			keys[num++] = ts->mac_key;
 	}
+
+unlock:
+	spin_unlock_bh(&g_tbl_lock);
+
+	return num;
+}
+
+/**************************************************************
+  Function:     unlink_host_entry
+  Description:  delete a host entry from hash table and lru
+                table, it's returned to a magazine after a
+                grace period. Called with g_tbl_lock held.
+  Input:        host, host entry
+**************************************************************/
+static void unlink_host_entry(struct host_entry *host)
+{
+	/* already deleted by another writer */
+	if (!host->linked)
+		return;
+
+	host->linked = 0;
+	g_host_count--;
+	/* the clock hand never points to an unlinked entry */
+	if (g_clock_hand == &host->lru_tbl_node)
+		g_clock_hand = host->lru_tbl_node.next;
+
+	hlist_delete(host);
+	list_del_rcu(&host->lru_tbl_node);
+	list_del_init(&host->expiry_node);
+	host_tombstone_add(host);
+	/* no CPU may hit this entry in its batch or neighbour cache any more */
+	atomic_inc(&g_host_remove_gen);
+	neigh_cache_invalidate_host(host);
+	call_rcu(&host->rcu, free_host_entry_rcu);
 }
 
 /**************************************************************
   Function:     free_last_lru_entry
-  Description:  delete the last entry of lru table, also delete
-                this entry from hash table, add it to free table
+  Description:  CLOCK eviction. Move the clock hand along lru
+                table, an entry referenced since the last pass
+                gets a second chance and its bit is cleared, the
+                first one not referenced is deleted from hash table
+                and lru table, and put back in a magazine after
+                a grace period. Called with g_tbl_lock held.
 **************************************************************/
 static void free_last_lru_entry(void)
 {
-	struct list_head *old = NULL;
 	struct host_entry *host = NULL;
+	struct list_head *pos = g_clock_hand;
+	unsigned int scanned = 0;
+	bool active;
 
-	old = list_del_last(g_lru_table);
-	if (old == NULL) {
-		printk(KERN_ERR "lru table is empty\n");
+	if (list_empty(g_lru_table)) {
+		printk_ratelimited(KERN_ERR "lru table is empty\n");
 		return;
 	}
 
-	/* delete this host entry from lru table */
-	host = list_entry(old, struct host_entry, lru_tbl_node);
-	/* delete this host entry from hash table */
-	hlist_delete(&(host->hash_tbl_node));
-	/* add this host entry to free table */
-	list_add_first(&(host->free_tbl_node), g_free_table);
+	if (pos == NULL)
+		pos = g_lru_table->next;
+
+	/* after one full pass all the bits are clear */
+	while (scanned++ <= 2 * g_host_count) {
+		if (pos == g_lru_table)
+			pos = pos->next;
+
+		host = list_entry(pos, struct host_entry, lru_tbl_node);
+		pos = pos->next;
+		if (!host->referenced)
+			break;
+
+		host->referenced = 0;
+	}
+
+	g_clock_hand = pos;
+
+	active = (jiffies - host_active_time(host)) / HZ < HOST_ACTIVE_TIME;
+	g_evict_count++;
+	if (active)
+		g_evict_active_count++;
+	dt_stat_inc(DT_STAT_EVICT);
+	trace_data_traffic_host_evict(host->mac_addr, scanned, active);
+
+	unlink_host_entry(host);
+}
+
+/**********************************************
+  Function:     expiry_wheel_init
+  Description:  init all the expiry wheel slots
+**********************************************/
+void expiry_wheel_init(void)
+{
+	int i;
+
+	for (i = 0; i < EXPIRY_WHEEL_SIZE; i++)
+		INIT_LIST_HEAD(&g_expiry_wheel[i]);
+	g_expiry_clock = 0;
+}
+
+/*************************************************************
+  Function:     expiry_wheel_add
+  Description:  queue a host entry in the expiry wheel, called
+                with g_tbl_lock held
+  Input:        host, host entry
+                delay, seconds from now, 1 to HOST_EXPIRE_TIME
+*************************************************************/
+static void expiry_wheel_add(struct host_entry *host, unsigned int delay)
+{
+	host->expires = g_expiry_clock + delay;
+	list_move_tail(&host->expiry_node,
+			&g_expiry_wheel[host->expires % EXPIRY_WHEEL_SIZE]);
+}
+
+/*************************************************************
+  Function:     expire_host_entries
+  Description:  called by the timer every second, check the
+                host entries queued for this second only. A host
+                which had traffic in the meantime is queued again
+                for HOST_EXPIRE_TIME after its last packet, the
+                others are deleted.
+  Return:       number of hosts deleted
+*************************************************************/
+unsigned int expire_host_entries(void)
+{
+	struct list_head *slot = NULL;
+	struct host_entry *host = NULL;
+	struct host_entry *tmp = NULL;
+	unsigned int expired = 0;
+	unsigned long idle;
+
+	spin_lock_bh(&g_tbl_lock);
+
+	g_expiry_clock++;
+	slot = &g_expiry_wheel[g_expiry_clock % EXPIRY_WHEEL_SIZE];
+	list_for_each_entry_safe(host, tmp, slot, expiry_node) {
+		idle = (jiffies - host_active_time(host)) / HZ;
+		if (idle >= HOST_EXPIRE_TIME) {
+			unlink_host_entry(host);
+			expired++;
+		} else {
+			expiry_wheel_add(host, HOST_EXPIRE_TIME - idle);
+		}
+	}
+
+	spin_unlock_bh(&g_tbl_lock);
+
+	dt_stat_add(DT_STAT_EXPIRE, expired);
+
+	return expired;
+}
+
+/*************************************************************
+  Function:     update_host_rates
+  Description:  called by the timer every second, advance the
+                rate estimator of every host
+*************************************************************/
+void update_host_rates(void)
+{
+	struct host_entry *host = NULL;
+
+	rcu_read_lock();
+	list_for_each_entry_rcu(host, g_lru_table, lru_tbl_node)
+		host_rate_update(host);
+	rcu_read_unlock();
 }
 
 /***************************************************
@@ -128,79 +522,302 @@ static void free_last_lru_entry(void)
   Description:  delete a host entry, including
                 1. delete this entry from hash table
                 2. delete this entry from lru table
-                3. add this endry to free table
+                3. put this endry back in a magazine
+                   after a grace period
   Input:        host, host entry
 ***************************************************/
 void remove_host_entry(struct host_entry *host)
 {
-	list_del_init(&(host->lru_tbl_node));
-	hlist_delete(&(host->hash_tbl_node));
-	list_add_first(&(host->free_tbl_node), g_free_table);
+	spin_lock_bh(&g_tbl_lock);
+	unlink_host_entry(host);
+	spin_unlock_bh(&g_tbl_lock);
+}
+
+/*************************************************************
+  Function:     police_apply_mac
+  Description:  apply the police rule of a MAC to its host entry,
+                if it's recorded. Done under the table lock, so
+                that an entry being published either is found
+                here or looks the rule up in
+                publish_free_host_entry after it's set.
+  Input:        mac_addr, MAC address whose rule changed
+*************************************************************/
+void police_apply_mac(unsigned char *mac_addr)
+{
+	struct host_entry *host = NULL;
 
+	rcu_read_lock();
+	spin_lock_bh(&g_tbl_lock);
+	host = hlist_find_host_by_mac(mac_addr);
+	if (host != NULL)
+		police_apply(host);
+	spin_unlock_bh(&g_tbl_lock);
+	rcu_read_unlock();
 }
+
+/*******************************************************
+  Function:     publish_free_host_entry
+  Description:  record a host in a free entry and publish
+                it into hash table, lru table and expiry
+                wheel. Called with table lock held.
+  Input:        host, free entry no reader can see
+                mac_addr, MAC address of the host
+                ip_addr, IP address of the host
+                ifindex, bridge port through which
+                         this host is connected
+  Return:       the new host entry
+******************************************************/
+static struct host_entry *publish_free_host_entry(struct host_entry *host,
+						unsigned char *mac_addr, unsigned int ip_addr,
+						int ifindex)
+{
+	/* record the MAC and IP address in host */
+	memcpy(host->mac_addr, mac_addr, ETH_ALEN);
+	host->mac_key = mac_to_key(mac_addr);
+	host->info.ip_addr = ip_addr;
+	host->info.ifindex = ifindex;
+
+	host_counter_reset(host);
+	host_rate_reset(host);
+	host_ip6_reset(host);
+	police_apply(host);
+	/* a new host survives the first pass of the clock hand */
+	host->referenced = 1;
+
+	/* publish this host entry into hash table and lru table */
+	hlist_add(host);
+	list_add_rcu(&host->lru_tbl_node, g_lru_table);
+	host->linked = 1;
+	g_host_count++;
+	expiry_wheel_add(host, HOST_EXPIRE_TIME);
+
+	return host;
+}
+
+/* grow the hash table once there are more hosts than buckets, table lock held */
+static void hash_table_grow_check(void)
+{
+	struct host_hash_table *tbl =
+		rcu_dereference_protected(g_hash_table, lockdep_is_held(&g_tbl_lock));
+
+	if (g_host_count > tbl->size && tbl->size < host_capacity)
+		schedule_work(&g_hash_resize_work);
+}
+
 /*******************************************************
   Function:     add_new_host_entry
   Description:  add a new host entry, including
-                delete this entry from free table
+                take a free entry from the magazine of
+                this CPU or another one, out of the table
+                lock
                 add this entry into hash table
                 add this entry into lru table
+                If all the magazines are empty and
+                host_capacity entries are allocated, an
+                entry not used recently is evicted, else
+                the refill work is pending. This host is
+                recorded by a later packet.
   Input:        mac_addr, MAC address of the host
                 ip_addr, IP address of the host
-                access_device_name, through which net
-                                    device this host is
-                                    connected to
+                ifindex, bridge port through which
+                         this host is connected
+  Return:       the host entry of this MAC address,
+                NULL if no free entry is available
 ******************************************************/
-void add_new_host_entry(unsigned char *mac_addr, unsigned int ip_addr, char *access_device_name)
+struct host_entry *add_new_host_entry(unsigned char *mac_addr, unsigned int ip_addr, int ifindex)
 {
-	struct list_head *free_entry = NULL;
+	struct host_entry *spare = host_entry_get();
 	struct host_entry *host = NULL;
-	int i;
 
-	/* if free table is empty, free the olded entry */
-	if (g_free_table->prev == g_free_table)
-		/* free table is empty, no free entry available */
-		free_last_lru_entry();
+	spin_lock_bh(&g_tbl_lock);
 
-	/* get a free entry */
-	free_entry = g_free_table->prev;
-	host = list_entry(free_entry, struct host_entry, free_tbl_node);
-	/* record the MAC and IP address in host */
-	for (i = 0; i < 6; i++)
-		host->info.mac_addr[i] = *(mac_addr + i);
+	/* another CPU may have recorded this host in the meantime */
+	host = hlist_find_host_by_mac(mac_addr);
+	if (host != NULL)
+		goto unlock;
 
-	host->info.ip_addr = ip_addr;
-	if (access_device_name)
-		memcpy(host->info.access_device_name, access_device_name, strlen(access_device_name));
-
-	host->stat.active_time = jiffies;
-	host->stat.download_speed = 0;
-	host->stat.download_speed_current = 0;
-	host->stat.download_total = 0;
-	host->stat.upload_speed = 0;
-	host->stat.upload_speed_current = 0;
-	host->stat.upload_total = 0;
-
-	/* add this host entry into hash table */
-	hlist_add(mac_addr, &host->hash_tbl_node);
-	/* add this host entry into lru table */
-	list_add_first(&host->lru_tbl_node, g_lru_table);
-	/* delete the entry from free table */
-	list_del(g_free_table->prev);
+	if (spare == NULL) {
+		/* no more entry to allocate, evict an entry not used recently */
+		if (host_entry_pool_full())
+			free_last_lru_entry();
+		goto unlock;
+	}
+
+	host = publish_free_host_entry(spare, mac_addr, ip_addr, ifindex);
+	spare = NULL;
+	hash_table_grow_check();
+	dt_stat_inc(DT_STAT_HOST_ADD);
+	trace_data_traffic_host_add(host->mac_addr, g_host_count);
+
+unlock:
+	spin_unlock_bh(&g_tbl_lock);
+
+	if (spare != NULL)
+		host_entry_put(spare);
+
+	return host;
 }
+
+/*******************************************************
+  Function:     restore_host_entries
+  Description:  restore the hosts of a dump. A host not
+                recorded yet takes a free entry, its totals
+                are set from its record and its rates are
+                restarted from them. A host already recorded
+                keeps its counters, restoring a dump twice
+                changes nothing. The hash table is sized for
+                the dump first. Nothing is evicted, the
+                restore stops once host_capacity entries are
+                allocated. Called in process context, entries
+                are allocated out of the table lock.
+  Input:        rec, records of the dump
+                num, number of records
+                restored, where to store the number of hosts
+                          restored
+  Return:       number of records done, restored or already
+                recorded, less than num if out of entries
+******************************************************/
+unsigned int restore_host_entries(struct dt_host_record *rec, unsigned int num,
+						unsigned int *restored)
+{
+	char name[DT_DEVICE_NAME_LEN + 1];
+	struct host_entry *spare = NULL;
+	struct host_entry *host = NULL;
+	struct net_device *dev = NULL;
+	unsigned int i;
+
+	*restored = 0;
+	hash_table_grow(ACCESS_ONCE(g_host_count) + num);
+
+	for (i = 0; i < num; i++) {
+		if (spare == NULL)
+			spare = host_entry_get();
+		if (spare == NULL)
+			spare = alloc_host_entry(numa_node_id());
+
+		/* the dump keeps the port name, ifindex changes across boots */
+		memset(name, 0, sizeof(name));
+		memcpy(name, rec[i].access_device_name,
+			strnlen(rec[i].access_device_name, DT_DEVICE_NAME_LEN));
+
+		rcu_read_lock();
+		dev = dev_get_by_name_rcu(&init_net, name);
+		spin_lock_bh(&g_tbl_lock);
+
+		host = hlist_find_host_by_mac(rec[i].mac_addr);
+		if (host == NULL && spare != NULL) {
+			host = publish_free_host_entry(spare, rec[i].mac_addr, rec[i].ip_addr,
+						dev != NULL ? dev->ifindex : 0);
+			spare = NULL;
+			hash_table_grow_check();
+			/* the counters were just reset, this sets the totals */
+			host_counter_add(host, &rec[i]);
+			host_rate_reset(host);
+			(*restored)++;
+		}
+
+		spin_unlock_bh(&g_tbl_lock);
+		rcu_read_unlock();
+
+		if (host == NULL)
+			break;
+	}
+
+	if (spare != NULL)
+		host_entry_put(spare);
+
+	return i;
+}
+
+/*******************************************************
+  Function:     lookup_or_add_host_entry
+  Description:  find host in hash table according to MAC
+                address, record it if not found. The hash
+                bucket is only walked once for a recorded
+                host. Called under rcu_read_lock().
+  Input:        mac_addr, MAC address of the host
+                ip_addr, IP address of the host
+                ifindex, bridge port through which
+                         this host is connected
+  Return:       the host entry of this MAC address,
+                NULL if no free entry is available
+******************************************************/
+struct host_entry *lookup_or_add_host_entry(unsigned char *mac_addr, unsigned int ip_addr, int ifindex)
+{
+	struct host_batch *batch = NULL;
+	struct host_entry *host = NULL;
+	unsigned int gen = 0;
+	u64 key = 0;
+
+	if (mac_addr == NULL)
+		return NULL;
+
+	/* a burst of packets of the same host is looked up only once */
+	if (batch_accounting) {
+		key = mac_to_key(mac_addr);
+		gen = atomic_read(&g_host_remove_gen);
+		batch = this_cpu_ptr(&g_host_batch);
+		if (batch->host != NULL && batch->mac_key == key && batch->gen == gen) {
+			dt_stat_inc(DT_STAT_BATCH_HIT);
+			return batch->host;
+		}
+		dt_stat_inc(DT_STAT_BATCH_MISS);
+	}
+
+	host = hlist_find_host_by_mac(mac_addr);
+	if (unlikely(host == NULL))
+		host = add_new_host_entry(mac_addr, ip_addr, ifindex);
+
+	if (batch != NULL) {
+		batch->mac_key = key;
+		batch->gen = gen;
+		batch->host = host;
+	}
+
+	return host;
+}
+
+/*************************************************************
+  Function:     hash_table_histogram
+  Description:  count the buckets of hash table by chain
+                length, the last slot counts all the longer
+                chains. Called under rcu_read_lock().
+  Input:        hist, HASH_HISTOGRAM_SIZE slots to fill
+  Return:       number of buckets of hash table
+*************************************************************/
+unsigned int hash_table_histogram(unsigned int *hist)
+{
+	struct host_hash_table *tbl = rcu_dereference(g_hash_table);
+	struct hlist_node *n = NULL;
+	unsigned int i, len;
+
+	memset(hist, 0, HASH_HISTOGRAM_SIZE * sizeof(*hist));
+
+	for (i = 0; i < tbl->size; i++) {
+		len = 0;
+		for (n = rcu_dereference(hlist_first_rcu(&tbl->buckets[i])); n != NULL;
+				n = rcu_dereference(hlist_next_rcu(n)))
+			len++;
+
+		hist[min_t(unsigned int, len, HASH_HISTOGRAM_SIZE - 1)]++;
+	}
+
+	return tbl->size;
+}
+
 /********************************
   Function:     table_size
-  Description:  get the table size
+  Description:  get the table size,
+                under rcu_read_lock()
   Input:        which table
 *********************************/
 int table_size(struct list_head *list)
 {
-	struct list_head *temp = list->next;
+	struct list_head *temp = NULL;
 	int i = 0;
 
-	while (temp != list) {
+	list_for_each_rcu(temp, list)
 		i++;
-		temp = temp->next;
-	}
 
 	return i;
 }
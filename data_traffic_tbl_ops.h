@@ -2,7 +2,7 @@
  * FILE NAME		:	data_traffic_tbl_ops.h
  * VERSION			:	1.0
  * DESCRIPTION		:	Operations on hash table, lru table and
- *						free table
+ *						host entry magazines
  *
  * AUTHOR			:	tangyupeng
  * CREATE DATE		:	11/10/2016
@@ -12,9 +12,23 @@
 
 #include "data_traffic_host_entry.h"
 
-extern struct hlist_node *hlist_find_host_by_mac(unsigned char *mac_addr);
-extern void add_new_host_entry(unsigned char *mac_addr, unsigned int ip_addr, char *access_device_name);
+/* removed hosts remembered for the netlink delta dumps */
+#define HOST_TOMBSTONE_NUM 1024
+
+extern int init_hash_table(void);
+extern void destroy_hash_table(void);
+extern struct host_entry *hlist_find_host_by_mac(unsigned char *mac_addr);
+extern struct host_entry *add_new_host_entry(unsigned char *mac_addr, unsigned int ip_addr, int ifindex);
+extern struct host_entry *lookup_or_add_host_entry(unsigned char *mac_addr, unsigned int ip_addr, int ifindex);
+extern unsigned int restore_host_entries(struct dt_host_record *rec, unsigned int num,
+						unsigned int *restored);
 extern void remove_host_entry(struct host_entry *host);
+extern void police_apply_mac(unsigned char *mac_addr);
 extern int table_size(struct list_head *list);
+extern void expiry_wheel_init(void);
+extern unsigned int expire_host_entries(void);
+extern void update_host_rates(void);
+extern unsigned int hash_table_histogram(unsigned int *hist);
+extern int host_tombstones_read(u32 since, u64 *keys, unsigned int max);
 
 #endif
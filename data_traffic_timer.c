@@ -1,9 +1,9 @@
 /*********************************************************
 * FILE NAME		:	data_traffic_timer.c
 * VERSION		:	1.0
-* DESCRIPTION	:	init timer, to zero upload/download speed
-*					of a host. If a host has no data traffic
-*					in a long period, delete it.
+* DESCRIPTION	:	init timer, expire the hosts queued in the
+*					expiry wheel for this second. If a host has
+*					no data traffic in a long period, delete it.
 *
 * AUTHOR		:	tangyupeng
 * CREATE DATE	:	13/10/2016
@@ -11,41 +11,51 @@
 #include <asm/param.h>
 #include <linux/jiffies.h>
 #include <linux/timer.h>
-#include <linux/list.h>
+#include <linux/timex.h>
+#include <linux/workqueue.h>
 #include "data_traffic_timer.h"
 #include "data_traffic_host_entry.h"
 #include "data_traffic_tbl_ops.h"
+#include "data_traffic_snapshot.h"
+#include "data_traffic_stats.h"
+#include "data_traffic_trace.h"
 
 struct timer_list data_traffic_timer;
 
+/*************************************************************
+  Function:     data_traffic_rate_work
+  Description:  advance the rate estimator of every host, then
+                publish the new speeds to the mapped snapshot.
+                Walking all the hosts is too long for the timer
+                itself, it's done in process context.
+*************************************************************/
+static void data_traffic_rate_work(struct work_struct *work)
+{
+	update_host_rates();
+	snapshot_schedule();
+}
+
+static DECLARE_WORK(g_rate_work, data_traffic_rate_work);
+
 /********************************************************************
   Function:     data_traffic_timer_function
-Description:    zero speed parameters every second, if a hsot doesn't
-                have data traffic in a long period, delete it
+Description:    expire the hosts due in this second, if a hsot doesn't
+                have data traffic in a long period, delete it. Then
+                queue the update of the rate estimators, so they
+                move every second whether they are read or not.
 *********************************************************************/
 static void data_traffic_timer_function(unsigned long data)
 {
-	struct list_head *cursor = NULL;
-	struct list_head *tmp = NULL;
-	struct host_entry *host = NULL;
-	unsigned int time = 0;
-
-	list_for_each_safe(cursor, tmp, g_lru_table) {
-		host = list_entry(cursor, struct host_entry, lru_tbl_node);
-		time = (jiffies - host->stat.active_time) / HZ;
-
-		host->stat.upload_speed = host->stat.upload_speed_current;
-		host->stat.download_speed = host->stat.download_speed_current;
+	cycles_t start = get_cycles();
+	unsigned int expired;
+	u64 cycles;
 
-		host->stat.upload_speed_current = 0;
-		host->stat.download_speed_current = 0;
+	expired = expire_host_entries();
+	cycles = get_cycles() - start;
+	dt_stat_sweep_cycles(cycles);
+	trace_data_traffic_timer_sweep(expired, cycles);
 
-		/**
-		 * If this host has no data traffic in last 10 mins, delete it.
-		 */
-		if (time > HOST_EXPIRE_TIME)
-			delete_host_entry(host);
-	}
+	schedule_work(&g_rate_work);
 
 	data_traffic_timer.expires = jiffies + HZ;
 	add_timer(&data_traffic_timer);
@@ -62,3 +72,13 @@ void data_traffic_timer_init(void)
 	data_traffic_timer.function = data_traffic_timer_function;
 	init_timer(&data_traffic_timer);
 }
+
+/*********************************************************
+  Function:     data_traffic_timer_exit
+  Description:  stop the timer and the rate update it queued
+**********************************************************/
+void data_traffic_timer_exit(void)
+{
+	del_timer_sync(&data_traffic_timer);
+	cancel_work_sync(&g_rate_work);
+}
@@ -14,5 +14,6 @@
 extern struct timer_list data_traffic_timer;
 
 extern void data_traffic_timer_init(void);
+extern void data_traffic_timer_exit(void);
 
 #endif
@@ -0,0 +1,111 @@
+/*********************************************************
+* FILE NAME		:	data_traffic_trace.h
+* VERSION		:	1.0
+* DESCRIPTION	:	Tracepoints of the packet path, host table
+*					and timer, under events/data_traffic. The
+*					tracepoints are defined in data_traffic_stats.c
+*
+* CREATE DATE	:	17/10/2026
+*********************************************************/
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM data_traffic
+
+#if !defined(_DATA_TRAFFIC_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _DATA_TRAFFIC_TRACE_H
+
+#include <linux/tracepoint.h>
+#include <linux/if_ether.h>
+
+TRACE_EVENT(data_traffic_hook,
+
+	TP_PROTO(unsigned int direction, unsigned int verdict, u64 cycles),
+
+	TP_ARGS(direction, verdict, cycles),
+
+	TP_STRUCT__entry(
+		__field(unsigned int, direction)
+		__field(unsigned int, verdict)
+		__field(u64, cycles)
+	),
+
+	TP_fast_assign(
+		__entry->direction = direction;
+		__entry->verdict = verdict;
+		__entry->cycles = cycles;
+	),
+
+	TP_printk("direction=%s verdict=%s cycles=%llu",
+		__entry->direction ? "upload" : "download",
+		__entry->verdict ? "accept" : "drop",
+		(unsigned long long)__entry->cycles)
+);
+
+TRACE_EVENT(data_traffic_host_add,
+
+	TP_PROTO(const unsigned char *mac_addr, unsigned int host_count),
+
+	TP_ARGS(mac_addr, host_count),
+
+	TP_STRUCT__entry(
+		__array(unsigned char, mac_addr, ETH_ALEN)
+		__field(unsigned int, host_count)
+	),
+
+	TP_fast_assign(
+		memcpy(__entry->mac_addr, mac_addr, ETH_ALEN);
+		__entry->host_count = host_count;
+	),
+
+	TP_printk("mac=%pM hosts=%u", __entry->mac_addr, __entry->host_count)
+);
+
+TRACE_EVENT(data_traffic_host_evict,
+
+	TP_PROTO(const unsigned char *mac_addr, unsigned int scanned, bool active),
+
+	TP_ARGS(mac_addr, scanned, active),
+
+	TP_STRUCT__entry(
+		__array(unsigned char, mac_addr, ETH_ALEN)
+		__field(unsigned int, scanned)
+		__field(bool, active)
+	),
+
+	TP_fast_assign(
+		memcpy(__entry->mac_addr, mac_addr, ETH_ALEN);
+		__entry->scanned = scanned;
+		__entry->active = active;
+	),
+
+	TP_printk("mac=%pM scanned=%u active=%d", __entry->mac_addr,
+		__entry->scanned, __entry->active)
+);
+
+TRACE_EVENT(data_traffic_timer_sweep,
+
+	TP_PROTO(unsigned int expired, u64 cycles),
+
+	TP_ARGS(expired, cycles),
+
+	TP_STRUCT__entry(
+		__field(unsigned int, expired)
+		__field(u64, cycles)
+	),
+
+	TP_fast_assign(
+		__entry->expired = expired;
+		__entry->cycles = cycles;
+	),
+
+	TP_printk("expired=%u cycles=%llu", __entry->expired,
+		(unsigned long long)__entry->cycles)
+);
+
+#endif
+
+/* out of tree, the module is built with -I$(src) */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE data_traffic_trace
+#include <trace/define_trace.h>